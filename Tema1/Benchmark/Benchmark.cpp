@@ -0,0 +1,445 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "Automaton.h"
+#include "ParallelMatcher.h"
+#include "StaticRegex.h"
+#include "ThreadPool.h"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+/// <summary>
+/// one benchmarked expression: the family it belongs to, its size parameter and the alphabet the input is drawn from
+/// </summary>
+struct BenchmarkCase
+{
+	std::string family;
+	std::size_t size;
+	std::string expression;
+	std::string inputAlphabet;
+};
+
+/// <summary>
+/// ((((a|b)*)*)*)... with depth nested stars, which makes long chains of lambda transitions
+/// </summary>
+/// <param name="depth"></param>
+/// <returns></returns>
+std::string nestedStars(std::size_t depth)
+{
+	std::string expression = "(a|b)";
+	for (std::size_t i = 0; i < depth; i++)
+		expression = "(" + expression + ")*";
+	return expression;
+}
+
+/// <summary>
+/// alternation of count distinct three letter words, like a list of keywords
+/// </summary>
+/// <param name="count"></param>
+/// <returns></returns>
+std::string longAlternation(std::size_t count)
+{
+	const std::string letters = "abcdefghijklmnopqrstuvwxyz";
+	std::string expression;
+	for (std::size_t i = 0; i < count; i++) {
+		if (i > 0)
+			expression += '|';
+		expression += letters[i / (26 * 26) % 26];
+		expression += '.';
+		expression += letters[i / 26 % 26];
+		expression += '.';
+		expression += letters[i % 26];
+	}
+	return expression;
+}
+
+/// <summary>
+/// (a|b)*.a.(a|b)...(a|b) with n trailing (a|b); the dfa has to remember the last n+1 symbols, so it has 2^(n+1) states
+/// </summary>
+/// <param name="n"></param>
+/// <returns></returns>
+std::string nthFromEnd(std::size_t n)
+{
+	std::string expression = "(a|b)*.a";
+	for (std::size_t i = 0; i < n; i++)
+		expression += ".(a|b)";
+	return expression;
+}
+
+/// <summary>
+/// concatenation of length pseudo random letters from abcd
+/// </summary>
+/// <param name="length"></param>
+/// <param name="random"></param>
+/// <returns></returns>
+std::string longConcatenation(std::size_t length, std::mt19937& random)
+{
+	std::string expression;
+	for (std::size_t i = 0; i < length; i++) {
+		if (i > 0)
+			expression += '.';
+		expression += "abcd"[random() % 4];
+	}
+	return expression;
+}
+
+/// <summary>
+/// concatenation of count terms cycling through [a-z], [0-9]+ and [a-z0-9]*; expanded writes every class as the
+/// alternation of its symbols instead, which is how such an expression had to be written before classes
+/// </summary>
+/// <param name="count"></param>
+/// <param name="expanded"></param>
+/// <returns></returns>
+std::string characterClasses(std::size_t count, bool expanded)
+{
+	const std::string letters = "abcdefghijklmnopqrstuvwxyz", digits = "0123456789";
+	auto charClass = [&](const std::string& symbols, const std::string& written) {
+		if (!expanded)
+			return written;
+		std::string alternation = "(";
+		for (const char symbol : symbols)
+			alternation += std::string(alternation.size() > 1 ? "|" : "") + symbol;
+		return alternation + ")";
+	};
+	std::string expression;
+	for (std::size_t i = 0; i < count; i++) {
+		if (i > 0)
+			expression += '.';
+		if (i % 3 == 0)
+			expression += charClass(letters, "[a-z]");
+		else if (i % 3 == 1)
+			expression += charClass(digits, "[0-9]") + "+";
+		else
+			expression += charClass(letters + digits, "[a-z0-9]") + "*";
+	}
+	return expression;
+}
+
+/// <summary>
+/// one of count rare marker bytes followed by two digits, like a field looked for in a log; the search spends
+/// nearly all its time in a state that only leaves on the markers
+/// </summary>
+/// <param name="count"></param>
+/// <returns></returns>
+std::string sparseExits(std::size_t count)
+{
+	return "[" + std::string("#@%").substr(0, count) + "].[0-9].[0-9]";
+}
+
+/// <summary>
+/// lowercase text with digits and spaces where the marker bytes of sparseExits(count) are about 1% of the bytes
+/// </summary>
+/// <param name="count"></param>
+/// <returns></returns>
+std::string sparseAlphabet(std::size_t count)
+{
+	const std::string text = "abcdefghijklmnopqrstuvwxyz0123456789 ";
+	std::string alphabet;
+	for (std::size_t i = 0; i < 3; i++)
+		alphabet += text;
+	return alphabet + std::string("#@%").substr(0, count);
+}
+
+/// <summary>
+/// alternation of count groups cycling through forms the RegexTree rewrites shrink: nested and repeated stars,
+/// duplicate branches, branches with a common first factor and single symbol branches
+/// </summary>
+/// <param name="count"></param>
+/// <returns></returns>
+std::string redundantForms(std::size_t count)
+{
+	const std::string groups[] = { "((a*)*.b)", "(c|c)", "((d*)+.a)", "(x|x.y)", "(a|b|c|d)", "(a.b|a.c)", "(b.(a|b)*.(a|b)*)", "(a.a*.d)" };
+	std::string expression;
+	for (std::size_t i = 0; i < count; i++) {
+		if (i > 0)
+			expression += '|';
+		expression += groups[i % std::size(groups)];
+	}
+	return "(" + expression + ")*.x";
+}
+
+std::vector<BenchmarkCase> createCases()
+{
+	std::mt19937 random(12345); // fixed seed, so every run benchmarks the same expressions
+	std::vector<BenchmarkCase> cases;
+	for (std::size_t depth : { 4, 16, 64 })
+		cases.push_back({ "nested_stars", depth, nestedStars(depth), "ab" });
+	for (std::size_t count : { 16, 128, 512 })
+		cases.push_back({ "long_alternation", count, longAlternation(count), "abcdefghijklmnopqrstuvwxyz" });
+	for (std::size_t n : { 4, 8, 12 })
+		cases.push_back({ "nth_from_end", n, nthFromEnd(n), "ab" });
+	for (std::size_t length : { 64, 512, 2048 })
+		cases.push_back({ "long_concatenation", length, longConcatenation(length, random), "abcd" });
+	for (std::size_t count : { 4, 16, 32 }) {
+		cases.push_back({ "char_classes", count, characterClasses(count, false), "abcxyz0189-" });
+		cases.push_back({ "char_classes_expanded", count, characterClasses(count, true), "abcxyz0189-" });
+	}
+	for (std::size_t count : { 1, 2, 3 })
+		cases.push_back({ "sparse_exits", count, sparseExits(count), sparseAlphabet(count) });
+	for (std::size_t count : { 4, 16, 64 })
+		cases.push_back({ "redundant_forms", count, redundantForms(count), "abcdxy" });
+	return cases;
+}
+
+/// <summary>
+/// pseudo random text of the given size over the alphabet, with a newline roughly every 80 bytes
+/// </summary>
+/// <param name="alphabet"></param>
+/// <param name="size"></param>
+/// <returns></returns>
+std::string generateInput(const std::string& alphabet, std::size_t size)
+{
+	std::mt19937 random(67890);
+	std::string input(size, '\n');
+	for (std::size_t i = 0; i < size; i++)
+		if (random() % 80 != 0)
+			input[i] = alphabet[random() % alphabet.size()];
+	return input;
+}
+
+/// <summary>
+/// best wall time of repeat runs of the function, in seconds; the minimum filters out noise from the rest of the system
+/// </summary>
+/// <param name="repeat"></param>
+/// <param name="function"></param>
+/// <returns></returns>
+double bestTime(std::size_t repeat, const std::function<void()>& function)
+{
+	double best = 0;
+	for (std::size_t i = 0; i < repeat; i++) {
+		const auto start = std::chrono::steady_clock::now();
+		function();
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		if (i == 0 || seconds < best)
+			best = seconds;
+	}
+	return best;
+}
+
+/// <summary>
+/// on linux the peak resident size is reset so that every case reports its own peak instead of the peak of the whole run
+/// </summary>
+void resetPeakMemory()
+{
+#ifdef __linux__
+	std::ofstream clearRefs("/proc/self/clear_refs");
+	clearRefs << "5";
+#endif
+}
+
+/// <summary>
+/// peak resident memory of the process in KiB
+/// </summary>
+/// <returns></returns>
+std::size_t peakMemoryKiB()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0;
+	return counters.PeakWorkingSetSize / 1024;
+#else
+#ifdef __linux__
+	std::ifstream status("/proc/self/status"); // VmHWM follows clear_refs, ru_maxrss does not
+	std::string key;
+	while (status >> key)
+		if (key == "VmHWM:") {
+			std::size_t kib = 0;
+			status >> kib;
+			return kib;
+		}
+#endif
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+	return static_cast<std::size_t>(usage.ru_maxrss) / 1024; // bytes on macOS
+#else
+	return static_cast<std::size_t>(usage.ru_maxrss);
+#endif
+#endif
+}
+
+double megabytesPerSecond(std::size_t bytes, double seconds)
+{
+	return seconds > 0 ? bytes / seconds / (1024.0 * 1024.0) : 0;
+}
+
+/// <summary>
+/// times every phase of one case and writes its results as a json object
+/// </summary>
+/// <param name="benchmark"></param>
+/// <param name="inputSize"></param>
+/// <param name="repeat"></param>
+/// <param name="pool">used for the parallel build</param>
+/// <param name="out"></param>
+void runCase(const BenchmarkCase& benchmark, std::size_t inputSize, std::size_t repeat, ThreadPool& pool, std::ostream& out)
+{
+	resetPeakMemory();
+	std::string postfix;
+	Automaton nfa, dfa;
+	IndexedNFA builtNFA, positionNFA;
+	MinimizationStats stats, glushkovStats;
+	CompiledDFA compiled;
+	const double postfixTime = bestTime(repeat, [&] { postfix = infixToPostfix(benchmark.expression); });
+	std::string simplified;
+	const double simplifyTime = bestTime(repeat, [&] { simplified = RegexTree::simplify(postfix); });
+	const SimplificationStats simplification = Automaton::measureSimplification(benchmark.expression);
+	const double nfaTime = bestTime(repeat, [&] { nfa = Automaton::createNFA(postfix); });
+	const double builderTime = bestTime(repeat, [&] { builtNFA = NFABuilder::fromPostfix(postfix); });
+	const double glushkovTime = bestTime(repeat, [&] { positionNFA = PositionAutomaton::fromPostfix(postfix); });
+	const double dfaTime = bestTime(repeat, [&] { dfa = nfa.convertToDFA(nfa); });
+	const double buildTime = bestTime(repeat, [&] { compiled = Automaton::buildCompiledDFA(benchmark.expression); });
+	const double parallelBuildTime = bestTime(repeat, [&] { compiled = Automaton::buildCompiledDFA(benchmark.expression, false, nullptr, &pool); });
+	const double minimizeTime = bestTime(repeat, [&] { compiled = Automaton::buildCompiledDFA(benchmark.expression, true, &stats); });
+	const double glushkovBuildTime = bestTime(repeat, [&] {
+		compiled = Automaton::buildCompiledDFA(benchmark.expression, true, &glushkovStats, nullptr, Construction::Glushkov);
+	});
+	const double parallelTime = bestTime(repeat, [&] { compiled = Automaton::buildCompiledDFA(benchmark.expression, true, nullptr, &pool); });
+	Searcher searcher = Automaton::buildSearcher(benchmark.expression);
+
+	const std::string input = generateInput(benchmark.inputAlphabet, inputSize);
+	bool accepted = false;
+	std::size_t matchCount = 0;
+	const double matchTime = bestTime(repeat, [&] { accepted = compiled.matches(input); });
+	const double searchTime = bestTime(repeat, [&] {
+		matchCount = searcher.search(input, SearchMode::LeftmostLongest, [](const Match&) {});
+	});
+	const double parallelMatchTime = bestTime(repeat, [&] { accepted = ParallelMatcher::matches(compiled, input, pool); });
+	const StreamPattern streamPattern = Automaton::buildStreamPattern(benchmark.expression);
+	std::size_t streamMatchCount = 0;
+	const double streamTime = bestTime(repeat, [&] { // fed in network packet sized buffers
+		StreamMatcher matcher(streamPattern);
+		for (std::size_t offset = 0; offset < input.size(); offset += 1500)
+			matcher.feed(input.data() + offset, std::min<std::size_t>(1500, input.size() - offset));
+		streamMatchCount = matcher.matchCount();
+	});
+	std::size_t allMatchCount = 0;
+	const double parallelSearchTime = bestTime(repeat, [&] {
+		allMatchCount = searcher.searchParallel(input, pool, [](const Match&) {});
+	});
+
+	out << "    {\n"
+		<< "      \"family\": \"" << benchmark.family << "\",\n"
+		<< "      \"size\": " << benchmark.size << ",\n"
+		<< "      \"expressionLength\": " << benchmark.expression.size() << ",\n"
+		<< "      \"seconds\": { \"infixToPostfix\": " << postfixTime << ", \"simplify\": " << simplifyTime << ", \"createNFA\": " << nfaTime
+		<< ", \"nfaBuilder\": " << builderTime << ", \"glushkovNFA\": " << glushkovTime << ", \"convertToDFA\": " << dfaTime << ", \"buildDFA\": " << buildTime
+		<< ", \"buildDFAParallel\": " << parallelBuildTime << ", \"buildMinimizedDFA\": " << minimizeTime
+		<< ", \"buildMinimizedDFAGlushkov\": " << glushkovBuildTime << ", \"buildMinimizedDFAParallel\": " << parallelTime << " },\n"
+		<< "      \"states\": { \"nfa\": " << nfa.stateCount() << ", \"nfaBuilder\": " << builtNFA.stateCount()
+		<< ", \"glushkovNFA\": " << positionNFA.stateCount() << ", \"dfa\": " << dfa.stateCount() << ", \"dfaGlushkov\": " << glushkovStats.statesBefore
+		<< ", \"minimizedDFA\": " << stats.statesAfter << ", \"accelerable\": " << compiled.accelerableStateCount()
+		<< ", \"accelerableSearch\": " << searcher.unanchored().accelerableStateCount()
+		<< ", \"nfaBeforeSimplification\": " << simplification.nfaStatesBefore << ", \"nfaAfterSimplification\": " << simplification.nfaStatesAfter
+		<< ", \"dfaBeforeSimplification\": " << simplification.dfaStatesBefore << ", \"dfaAfterSimplification\": " << simplification.dfaStatesAfter << " },\n"
+		<< "      \"peakMemoryKiB\": " << peakMemoryKiB() << ",\n"
+		<< "      \"inputBytes\": " << input.size() << ",\n"
+		<< "      \"matchMBps\": " << megabytesPerSecond(input.size(), matchTime) << ",\n"
+		<< "      \"searchMBps\": " << megabytesPerSecond(input.size(), searchTime) << ",\n"
+		<< "      \"parallelMatchMBps\": " << megabytesPerSecond(input.size(), parallelMatchTime) << ",\n"
+		<< "      \"parallelAllMatchesSearchMBps\": " << megabytesPerSecond(input.size(), parallelSearchTime) << ",\n"
+		<< "      \"streamMBps\": " << megabytesPerSecond(input.size(), streamTime) << ",\n"
+		<< "      \"accepted\": " << (accepted ? "true" : "false") << ",\n"
+		<< "      \"searchMatches\": " << matchCount << ",\n"
+		<< "      \"allMatches\": " << allMatchCount << ",\n"
+		<< "      \"streamMatches\": " << streamMatchCount << "\n"
+		<< "    }";
+}
+
+/// <summary>
+/// matches the input with the runtime dfa of an expression and with its StaticRegex; staticRegexTest checks that they
+/// accept the same words
+/// </summary>
+/// <param name="inputSize"></param>
+/// <param name="repeat"></param>
+/// <param name="out"></param>
+template <StaticRegexDetail::Pattern Expression>
+void runStaticCase(std::size_t inputSize, std::size_t repeat, std::ostream& out)
+{
+	const std::string expression(Expression.view());
+	const CompiledDFA compiled = Automaton::buildCompiledDFA(expression, true);
+	const std::string input = generateInput(compiled.alphabet(), inputSize);
+	bool accepted = false, staticAccepted = false;
+	const double matchTime = bestTime(repeat, [&] { accepted = compiled.matches(input); });
+	const double staticMatchTime = bestTime(repeat, [&] { staticAccepted = StaticRegex<Expression>::matches(input); });
+
+	out << "    {\n"
+		<< "      \"expression\": \"" << expression << "\",\n"
+		<< "      \"states\": { \"minimizedDFA\": " << compiled.stateCount() << ", \"staticRegex\": " << StaticRegex<Expression>::stateCount() << " },\n"
+		<< "      \"matchMBps\": " << megabytesPerSecond(input.size(), matchTime) << ",\n"
+		<< "      \"staticMatchMBps\": " << megabytesPerSecond(input.size(), staticMatchTime) << ",\n"
+		<< "      \"accepted\": " << (accepted ? "true" : "false") << ",\n"
+		<< "      \"staticAccepted\": " << (staticAccepted ? "true" : "false") << "\n"
+		<< "    }";
+}
+
+/// <summary>
+/// benchmark [--repeat N] [--input-mb N] [--family name]; prints the results of every case as json on the standard output
+/// </summary>
+/// <param name="argc"></param>
+/// <param name="argv"></param>
+/// <returns></returns>
+int main(int argc, char* argv[])
+{
+	std::size_t repeat = 3;
+	std::size_t inputMegabytes = 16;
+	std::string family;
+	for (int i = 1; i < argc; i++) {
+		const std::string option = argv[i];
+		if (i + 1 < argc && option == "--repeat")
+			repeat = std::stoul(argv[++i]);
+		else if (i + 1 < argc && option == "--input-mb")
+			inputMegabytes = std::stoul(argv[++i]);
+		else if (i + 1 < argc && option == "--family")
+			family = argv[++i];
+		else {
+			std::cerr << "Usage: benchmark [--repeat N] [--input-mb N] [--family name]\n";
+			return 1;
+		}
+	}
+	if (repeat == 0)
+		repeat = 1;
+
+	ThreadPool pool;
+	std::cout << "{\n  \"repeat\": " << repeat << ",\n  \"threads\": " << pool.threadCount() << ",\n  \"cases\": [\n";
+	bool first = true;
+	for (const BenchmarkCase& benchmark : createCases()) {
+		if (!family.empty() && benchmark.family != family)
+			continue;
+		if (!first)
+			std::cout << ",\n";
+		first = false;
+		runCase(benchmark, inputMegabytes * 1024 * 1024, repeat, pool, std::cout);
+		std::cout.flush();
+	}
+	std::cout << "\n  ]";
+	if (family.empty() || family == "static") {
+		const std::size_t inputSize = inputMegabytes * 1024 * 1024;
+		std::cout << ",\n  \"static\": [\n";
+		runStaticCase<"a.(b|c)*">(inputSize, repeat, std::cout);
+		std::cout << ",\n";
+		runStaticCase<"(a|b)*.a.b.b">(inputSize, repeat, std::cout);
+		std::cout << ",\n";
+		runStaticCase<"(a|b)*.a.(a|b).(a|b).(a|b)">(inputSize, repeat, std::cout);
+		std::cout << ",\n";
+		runStaticCase<"[a-z_].[a-z0-9_]*">(inputSize, repeat, std::cout);
+		std::cout << ",\n";
+		runStaticCase<"[^0-9]+.[0-9].[0-9]?">(inputSize, repeat, std::cout);
+		std::cout << ",\n";
+		runStaticCase<"(a.b?|[]^-]+).c?.(x|y)+">(inputSize, repeat, std::cout);
+		std::cout << "\n  ]";
+	}
+	std::cout << "\n}\n";
+	return 0;
+}
@@ -0,0 +1,235 @@
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "MatchProtocol.h"
+
+using Clock = std::chrono::steady_clock;
+
+/// <summary>
+/// what every connection sends: count requests of one kind, keeping up to depth of them in flight
+/// </summary>
+struct LoadSettings
+{
+	std::string path;
+	std::size_t connections = 4;
+	std::size_t depth = 32;
+	std::size_t requests = 20000; // per connection
+	std::size_t batch = 64; // words per Match request
+	std::size_t textBytes = 4096; // text of a Search request
+	std::uint16_t pattern = 0;
+	MatchProtocol::Op op = MatchProtocol::Op::Match;
+	std::string alphabet = "ab";
+};
+
+/// <summary>
+/// latencies in microseconds of the requests of one connection, and how many were not answered with Ok
+/// </summary>
+struct ConnectionResult
+{
+	std::vector<double> latencies;
+	std::size_t errors = 0;
+	bool connected = false;
+};
+
+int connectTo(const std::string& path)
+{
+	sockaddr_un address{};
+	if (path.size() >= sizeof(address.sun_path))
+		return -1;
+	address.sun_family = AF_UNIX;
+	std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+	const int socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (socket >= 0 && ::connect(socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+		::close(socket);
+		return -1;
+	}
+	return socket;
+}
+
+bool readAll(int socket, char* data, std::size_t size)
+{
+	while (size > 0) {
+		const ssize_t count = ::recv(socket, data, size, 0);
+		if (count <= 0)
+			return false;
+		data += count;
+		size -= static_cast<std::size_t>(count);
+	}
+	return true;
+}
+
+bool writeAll(int socket, const char* data, std::size_t size)
+{
+	while (size > 0) {
+		const ssize_t count = ::send(socket, data, size, 0);
+		if (count <= 0)
+			return false;
+		data += count;
+		size -= static_cast<std::size_t>(count);
+	}
+	return true;
+}
+
+/// <summary>
+/// a few different payloads drawn from a fixed seed, reused round robin so generating them is not measured
+/// </summary>
+/// <param name="settings"></param>
+/// <returns></returns>
+std::vector<std::string> createPayloads(const LoadSettings& settings)
+{
+	std::mt19937 random(42);
+	std::uniform_int_distribution<std::size_t> symbol(0, settings.alphabet.size() - 1);
+	std::uniform_int_distribution<std::size_t> wordLength(1, 16);
+	std::vector<std::string> payloads(64);
+	for (std::string& payload : payloads) {
+		if (settings.op == MatchProtocol::Op::Match)
+			for (std::size_t i = 0; i < settings.batch; i++) {
+				std::string word(wordLength(random), '\0');
+				for (char& c : word)
+					c = settings.alphabet[symbol(random)];
+				MatchProtocol::appendWord(payload, word);
+			}
+		else
+			for (std::size_t i = 0; i < settings.textBytes; i++)
+				payload += settings.alphabet[symbol(random)];
+	}
+	return payloads;
+}
+
+/// <summary>
+/// sends the requests of one connection without waiting for the answers, as long as fewer than depth are pending
+/// </summary>
+/// <param name="settings"></param>
+/// <param name="payloads"></param>
+/// <param name="result"></param>
+void runConnection(const LoadSettings& settings, const std::vector<std::string>& payloads, ConnectionResult& result)
+{
+	const int socket = connectTo(settings.path);
+	if (socket < 0)
+		return;
+	result.connected = true;
+	std::vector<std::string> frames;
+	for (const std::string& payload : payloads)
+		frames.push_back(MatchProtocol::frame({ 0, 0, settings.pattern, static_cast<std::uint8_t>(settings.op), 0 }, payload));
+	std::vector<Clock::time_point> sentAt(settings.requests);
+	result.latencies.reserve(settings.requests);
+	std::size_t sent = 0;
+	std::size_t received = 0;
+	char header[MatchProtocol::kHeaderSize];
+	std::string payload;
+	while (received < settings.requests) {
+		for (; sent < settings.requests && sent - received < settings.depth; sent++) {
+			std::string& frame = frames[sent % frames.size()];
+			MatchProtocol::putUint32(frame.data() + 4, static_cast<std::uint32_t>(sent)); // request id
+			sentAt[sent] = Clock::now();
+			if (!writeAll(socket, frame.data(), frame.size()))
+				break;
+		}
+		if (!readAll(socket, header, sizeof(header)))
+			break;
+		const MatchProtocol::FrameHeader response = MatchProtocol::decodeHeader(header);
+		payload.resize(response.length);
+		if (!readAll(socket, payload.data(), payload.size()) || response.requestId >= sent)
+			break;
+		result.latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - sentAt[response.requestId]).count());
+		if (response.status != static_cast<std::uint8_t>(MatchProtocol::Status::Ok))
+			result.errors++;
+		received++;
+	}
+	result.errors += settings.requests - received; // lost when the connection broke
+	::close(socket);
+}
+
+double percentile(const std::vector<double>& sorted, double fraction)
+{
+	if (sorted.empty())
+		return 0;
+	return sorted[std::min(sorted.size() - 1, static_cast<std::size_t>(fraction * sorted.size()))];
+}
+
+int main(int argc, char* argv[])
+{
+	LoadSettings settings;
+	std::string op = "match";
+	bool valid = argc >= 2;
+	if (valid)
+		settings.path = argv[1];
+	for (int i = 2; valid && i < argc; i++) {
+		const std::string option = argv[i];
+		if (i + 1 >= argc)
+			valid = false;
+		else if (option == "--connections")
+			settings.connections = std::stoul(argv[++i]);
+		else if (option == "--depth")
+			settings.depth = std::stoul(argv[++i]);
+		else if (option == "--requests")
+			settings.requests = std::stoul(argv[++i]);
+		else if (option == "--batch")
+			settings.batch = std::stoul(argv[++i]);
+		else if (option == "--text-bytes")
+			settings.textBytes = std::stoul(argv[++i]);
+		else if (option == "--pattern")
+			settings.pattern = static_cast<std::uint16_t>(std::stoul(argv[++i]));
+		else if (option == "--alphabet")
+			settings.alphabet = argv[++i];
+		else if (option == "--op")
+			op = argv[++i];
+		else
+			valid = false;
+	}
+	if (op == "match")
+		settings.op = MatchProtocol::Op::Match;
+	else if (op == "search")
+		settings.op = MatchProtocol::Op::Search;
+	else if (op == "search-all")
+		settings.op = MatchProtocol::Op::SearchAll;
+	else
+		valid = false;
+	if (!valid || settings.alphabet.empty()) {
+		std::cerr << "Usage: loadgen <socket> [--connections N] [--depth N] [--requests N] [--op match|search|search-all]"
+			" [--batch N] [--text-bytes N] [--pattern N] [--alphabet chars]\n";
+		return 1;
+	}
+	// deeper pipelines would stall: the server stops reading while the client is still writing instead of reading
+	settings.depth = std::clamp<std::size_t>(settings.depth, 1, MatchProtocol::kMaxInFlight);
+	settings.connections = std::max<std::size_t>(settings.connections, 1);
+
+	std::signal(SIGPIPE, SIG_IGN); // a server that goes away shows up as errors
+	const std::vector<std::string> payloads = createPayloads(settings);
+	std::vector<ConnectionResult> results(settings.connections);
+	std::vector<std::thread> threads;
+	const Clock::time_point start = Clock::now();
+	for (std::size_t i = 0; i < settings.connections; i++)
+		threads.emplace_back(runConnection, std::cref(settings), std::cref(payloads), std::ref(results[i]));
+	for (auto& thread : threads)
+		thread.join();
+	const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	std::vector<double> latencies;
+	std::size_t errors = 0;
+	for (const ConnectionResult& result : results) {
+		if (!result.connected) {
+			std::cerr << "Failed to connect to " << settings.path << "\n";
+			return 1;
+		}
+		latencies.insert(latencies.end(), result.latencies.begin(), result.latencies.end());
+		errors += result.errors;
+	}
+	std::sort(latencies.begin(), latencies.end());
+	std::cout << "{\n  \"op\": \"" << op << "\",\n  \"connections\": " << settings.connections << ",\n  \"depth\": " << settings.depth
+		<< ",\n  \"requests\": " << latencies.size() << ",\n  \"errors\": " << errors << ",\n  \"seconds\": " << seconds
+		<< ",\n  \"requestsPerSecond\": " << (seconds > 0 ? latencies.size() / seconds : 0)
+		<< ",\n  \"p50Micros\": " << percentile(latencies, 0.50) << ",\n  \"p99Micros\": " << percentile(latencies, 0.99)
+		<< ",\n  \"maxMicros\": " << (latencies.empty() ? 0 : latencies.back()) << "\n}\n";
+	return errors == 0 ? 0 : 1;
+}
@@ -1,8 +1,9 @@
 #include "Automaton.h"
 #include <algorithm>
+#include <vector>
 
 int priority(char c) {
-	if (c == '*' || c == '+')
+	if (c == '*' || c == '+' || c == '?')
 		return 3;
 	else if (c == '.')
 		return 2;
@@ -13,6 +14,7 @@ int priority(char c) {
 }
 
 std::string infixToPostfix(const std::string& s) {
+	STATS_PHASE(Postfix);
 	std::stack<char> st; // stack of symbols
 	std::string result = ""; // string in polish form
 	for (int i = 0; i < s.length(); i++) {
@@ -20,6 +22,12 @@ std::string infixToPostfix(const std::string& s) {
 		// if it is a valid character add it to the string
 		if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9'))
 			result += c;
+		// a character class like [a-z0-9_] is one operand, copied as it is
+		else if (c == '[') {
+			const std::size_t end = CharClass::operandEnd(s, i);
+			result.append(s, i, end - i);
+			i = static_cast<int>(end) - 1;
+		}
 		// if it is an open paranthesis add it to the stack of symbols
 		else if (c == '(')
 			st.push('(');
@@ -62,6 +70,24 @@ Automaton::Automaton(char symbol, int& counter) {
 	m_transitionFunctions[startState][symbol].insert(endState); // from start state with current symbol you end up in end state
 }
 
+/// <summary>
+/// creates an automaton whose start state goes to its final state on every byte of the class
+/// </summary>
+/// <param name="symbols"></param>
+/// <param name="counter"></param>
+Automaton::Automaton(const CharClass& symbols, int& counter) {
+	std::string startState = "q" + std::to_string(counter++);
+	std::string endState = "q" + std::to_string(counter++);
+	m_states = { startState, endState };
+	m_initialState = startState;
+	m_finalStates = { endState };
+	for (const CharClass::Range& range : symbols.ranges())
+		for (unsigned int byte = std::max(range.first, static_cast<unsigned char>(1)); byte <= range.last; byte++) { // '\0' is lambda here
+			m_alphabet.insert(static_cast<char>(byte));
+			m_transitionFunctions[startState][static_cast<char>(byte)].insert(endState);
+		}
+}
+
 /// <summary>
 /// concatenates two automatons into one 
 /// </summary>
@@ -200,11 +226,45 @@ Automaton Automaton::quantify(const Automaton& a, int& counter) { // basically +
 	return result;
 }
 
+/// <summary>
+/// zero or one occurrence of a: like kleeneStar, but the final states of a do not go back to its initial state
+/// </summary>
+/// <param name="a"></param>
+/// <param name="counter"></param>
+/// <returns></returns>
+Automaton Automaton::optional(const Automaton& a, int& counter) { // basically ?
+	Automaton result;
+	result.m_states = a.m_states;
+	result.m_alphabet = a.m_alphabet;
+	std::string startState = "q" + std::to_string(counter++);
+	std::string endState = "q" + std::to_string(counter++);
+	result.m_states.insert({ startState, endState });
+	result.m_initialState = startState;
+	result.m_finalStates = { endState };
+	result.m_transitionFunctions = a.m_transitionFunctions;
+	result.m_transitionFunctions[startState]['\0'] = { a.m_initialState, endState }; // either through a or straight to the end
+	for (const auto& final : a.m_finalStates)
+		result.m_transitionFunctions[final]['\0'].insert(endState);
+	return result;
+}
+
 Automaton Automaton::createNFA(const std::string& polishForm) {
+	STATS_PHASE(Thompson);
 	int counter = 0;
 	std::stack<Automaton> sa;
-	for (auto& symbol : polishForm) {
-		if (symbol != '*' && symbol != '.' && symbol != '|' && symbol != '+') {
+	for (std::size_t i = 0; i < polishForm.size(); i++) {
+		const char symbol = polishForm[i];
+		if (symbol == '[') {
+			const std::size_t end = CharClass::operandEnd(polishForm, i);
+			CharClass symbols;
+			if (!CharClass::parse(polishForm, i, end, symbols)) {
+				sa = {};
+				break;
+			}
+			sa.push(Automaton(symbols, counter));
+			i = end - 1;
+		}
+		else if (symbol != '*' && symbol != '.' && symbol != '|' && symbol != '+' && symbol != '?') {
 			sa.push(Automaton(symbol, counter));
 		}
 		else if (symbol == '|') {
@@ -223,6 +283,11 @@ Automaton Automaton::createNFA(const std::string& polishForm) {
 			Automaton result = Automaton::quantify(a, counter);
 			sa.push(result);
 		}
+		else if (symbol == '?') {
+			Automaton a = sa.top(); sa.pop();
+			Automaton result = Automaton::optional(a, counter);
+			sa.push(result);
+		}
 		else if (symbol == '.') {
 			Automaton b = sa.top(); sa.pop();
 			Automaton a = sa.top(); sa.pop();
@@ -290,14 +355,140 @@ void Automaton::checkWord(const std::string& word) const {
 	return ;
 }
 
-Automaton Automaton::buildDFA(const std::string& expr){
-	std::string regex = infixToPostfix(expr);
-	Automaton nfa = Automaton::createNFA(regex);
-	Automaton dfa = nfa.convertToDFA(nfa);
+/// <summary>
+/// builds a dfa from a regex; when minimize is set the subset construction output goes through hopcroft's
+/// minimization and, if stats is given, the state counts before and after are stored there
+/// </summary>
+/// <param name="expr"></param>
+/// <param name="minimize"></param>
+/// <param name="stats"></param>
+/// <param name="construction">thompson or glushkov nfa; both give the same minimized dfa</param>
+/// <returns></returns>
+Automaton Automaton::buildDFA(const std::string& expr, bool minimize, MinimizationStats* stats, Construction construction){
+	return fromCompiledDFA(buildCompiledDFA(expr, minimize, stats, nullptr, construction));
+}
+
+/// <summary>
+/// numbers the states of a dfa (as returned by buildDFA) and packs its transitions into a CompiledDFA;
+/// states are numbered in breadth first order from the initial state, 0 is reserved for the dead state
+/// </summary>
+/// <returns></returns>
+CompiledDFA Automaton::compile() const {
+	std::string alphabet(m_alphabet.begin(), m_alphabet.end());
+	std::sort(alphabet.begin(), alphabet.end()); // fixed symbol order so the numbering does not depend on hashing
+
+	std::unordered_map<std::string, CompiledDFA::State> ids; // automaton state -> integer id
+	std::vector<std::string> order; // integer id - 1 -> automaton state
+	std::queue<std::string> toVisit;
+	ids[m_initialState] = 1;
+	order.push_back(m_initialState);
+	toVisit.push(m_initialState);
+	while (!toVisit.empty()) {
+		std::string current = toVisit.front();
+		toVisit.pop();
+		auto it = m_transitionFunctions.find(current);
+		if (it == m_transitionFunctions.end())
+			continue;
+		for (const char symbol : alphabet) {
+			auto itt = it->second.find(symbol);
+			if (itt == it->second.end() || itt->second.empty())
+				continue;
+			const std::string& target = *itt->second.begin(); // a dfa has exactly one target per symbol
+			if (ids.emplace(target, static_cast<CompiledDFA::State>(order.size() + 1)).second) {
+				order.push_back(target);
+				toVisit.push(target);
+			}
+		}
+	}
+
+	CompiledDFA compiled(alphabet, order.size() + 1, 1);
+	for (const auto& [state, id] : ids) {
+		if (m_finalStates.count(state))
+			compiled.setAccepting(id);
+		auto it = m_transitionFunctions.find(state);
+		if (it == m_transitionFunctions.end())
+			continue;
+		for (const auto& [symbol, targetStates] : it->second)
+			if (symbol != '\0' && !targetStates.empty())
+				compiled.setTransition(id, symbol, ids.at(*targetStates.begin()));
+	}
+	compiled.compressClasses();
+	compiled.computeAcceleration();
+	return compiled;
+}
+
+/// <summary>
+/// the integer nfa of a regex, built with the chosen construction (this skips the named states of createNFA)
+/// </summary>
+/// <param name="expr"></param>
+/// <param name="construction"></param>
+/// <returns></returns>
+IndexedNFA Automaton::buildIndexedNFA(const std::string& expr, Construction construction) {
+	const std::string regex = RegexTree::simplify(infixToPostfix(expr));
+	if (construction == Construction::Glushkov)
+		return PositionAutomaton::fromPostfix(regex);
+	return NFABuilder::fromPostfix(regex);
+}
+
+/// <summary>
+/// builds the dfa of a regex straight in its table form; with a pool the subset construction runs on all of its
+/// threads, which gives the same dfa
+/// </summary>
+/// <param name="expr"></param>
+/// <param name="minimize"></param>
+/// <param name="stats"></param>
+/// <param name="pool"></param>
+/// <param name="construction"></param>
+/// <returns></returns>
+CompiledDFA Automaton::buildCompiledDFA(const std::string& expr, bool minimize, MinimizationStats* stats, ThreadPool* pool, Construction construction) {
+	const IndexedNFA nfa = buildIndexedNFA(expr, construction);
+	CompiledDFA dfa = pool ? CompiledDFA::fromNFAParallel(nfa, *pool) : CompiledDFA::fromNFA(nfa);
+	if (minimize)
+		return dfa.minimize(stats);
 	return dfa;
 }
 
+/// <summary>
+/// builds only the nfa; the dfa states are created while matching, within the given memory budget
+/// </summary>
+/// <param name="expr"></param>
+/// <param name="memoryBudget"></param>
+/// <returns></returns>
+LazyDFA Automaton::buildLazyDFA(const std::string& expr, std::size_t memoryBudget) {
+	return LazyDFA(NFABuilder::fromPostfix(RegexTree::simplify(infixToPostfix(expr))), memoryBudget);
+}
 
+Searcher Automaton::buildSearcher(const std::string& expr) {
+	std::string regex = RegexTree::simplify(infixToPostfix(expr));
+	return Searcher(NFABuilder::fromPostfix(regex), Prefilter::fromPostfix(regex));
+}
+
+/// <summary>
+/// builds the dfas shared by the StreamMatchers of the expression
+/// </summary>
+/// <param name="expr"></param>
+/// <returns></returns>
+StreamPattern Automaton::buildStreamPattern(const std::string& expr) {
+	return StreamPattern::fromPostfix(RegexTree::simplify(infixToPostfix(expr)));
+}
+
+/// <summary>
+/// state counts of the thompson nfa and of the dfa (not minimized) of an expression, built from its polish form as
+/// written and after the RegexTree rewrites the build functions apply
+/// </summary>
+/// <param name="expr"></param>
+/// <returns></returns>
+SimplificationStats Automaton::measureSimplification(const std::string& expr) {
+	const std::string regex = infixToPostfix(expr);
+	const IndexedNFA before = NFABuilder::fromPostfix(regex);
+	const IndexedNFA after = NFABuilder::fromPostfix(RegexTree::simplify(regex));
+	SimplificationStats stats;
+	stats.nfaStatesBefore = before.stateCount();
+	stats.nfaStatesAfter = after.stateCount();
+	stats.dfaStatesBefore = CompiledDFA::fromNFA(before).stateCount() - 1; // without the dead state
+	stats.dfaStatesAfter = CompiledDFA::fromNFA(after).stateCount() - 1;
+	return stats;
+}
 
 /// <summary>
 /// stores all the lambda transitions
@@ -327,85 +518,63 @@ std::unordered_set<std::string> Automaton::lambdaClosure(const std::string& stat
 }
 
 /// <summary>
-/// constructs dfa states from nfa states by mapping them
+/// numbers the states of the automaton (the initial state gets 0, the rest follow in name order)
+/// and copies its transitions into an IndexedNFA
 /// </summary>
-/// <param name="nfa"></param>
-/// <param name="newStates"></param>
-/// <param name="newcounter"></param>
-/// <param name="dfa"></param>
 /// <returns></returns>
-std::unordered_map<std::string, std::string> Automaton::createDFAStatesFromNFA(const Automaton& nfa, std::queue<std::unordered_set<std::string>>& newStates, int& newcounter, Automaton& dfa) const {
-	std::unordered_map<std::string, std::string> allStates; // map where the key is a string representing a nfa state and the value is a corresponding dfa name
-
-	std::unordered_set<std::string> startClosure = nfa.lambdaClosure(nfa.m_initialState); // calculates the lambda closures of the nfa's initial state
-	std::string startKey;
-	std::vector<std::string> sortedStates(startClosure.begin(), startClosure.end()); // the lambda closure set is converted to a vector that can be sorted so that the key generated is consistent and unique for the same set of states
-	std::sort(sortedStates.begin(), sortedStates.end());
-	for (const auto& state : sortedStates) // the sorted states are concatenated into a string with each state separated by ,
-		startKey += state + ",";
-
-	std::string startState = "q" + std::to_string(newcounter++) + "'"; 
-	allStates[startKey] = startState; // assigns a unique dfa state to the lambda closure of the nfa's initial state
-	dfa.m_states.insert(startState); // the state is added to the dfa's states set
-	dfa.m_initialState = startState; // dfa's initial state is set to the start state
-	newStates.push(startClosure); // allows further processing of nfa states
-	return allStates;
+IndexedNFA Automaton::toIndexedNFA() const {
+	STATS_PHASE(Indexing);
+	std::vector<std::string> names(m_states.begin(), m_states.end());
+	for (const auto& [state, transitions] : m_transitionFunctions) { // concatenation can leave states that are only referenced by transitions
+		names.push_back(state);
+		for (const auto& [symbol, targetStates] : transitions)
+			names.insert(names.end(), targetStates.begin(), targetStates.end());
+	}
+	std::sort(names.begin(), names.end());
+	names.erase(std::unique(names.begin(), names.end()), names.end());
+	std::unordered_map<std::string, IndexedNFA::StateId> ids; // state name -> integer id
+	ids[m_initialState] = 0;
+	for (const auto& name : names)
+		ids.emplace(name, static_cast<IndexedNFA::StateId>(ids.size()));
+
+	IndexedNFA nfa(std::string(m_alphabet.begin(), m_alphabet.end()), ids.size(), 0);
+	for (const auto& [state, transitions] : m_transitionFunctions)
+		for (const auto& [symbol, targetStates] : transitions)
+			for (const auto& target : targetStates)
+				if (symbol == '\0')
+					nfa.addLambdaEdge(ids.at(state), ids.at(target));
+				else
+					nfa.addEdge(ids.at(state), symbol, ids.at(target));
+	for (const auto& finalState : m_finalStates)
+		nfa.setFinal(ids.at(finalState));
+	nfa.computeClosures();
+	return nfa;
 }
 
 /// <summary>
-/// constructs a dfa's final states as well as its transition functions based on a nfa
+/// turns a CompiledDFA back into an automaton with named states; state k of the table becomes q(k-1)' and the dead state is dropped
 /// </summary>
-/// <param name="nfa"></param>
-/// <param name="newStates"></param>
-/// <param name="allStates"></param>
-/// <param name="newcounter"></param>
-/// <param name="dfa"></param>
-void Automaton::processTransitionsAndFinalStates(const Automaton& nfa, std::queue<std::unordered_set<std::string>>& newStates, std::unordered_map<std::string, std::string>& allStates, int& newcounter, Automaton& dfa) const {
-	while (!newStates.empty()) { // while there are unhandled states
-		auto currentState = newStates.front();
-		newStates.pop();
-		std::string currentKey; // generates unique key for each state set
-		std::vector<std::string> sortedCurrentState(currentState.begin(), currentState.end()); // declares a vector that can be sorted so that the key generated is consistent and unique for the same set of states
-		std::sort(sortedCurrentState.begin(), sortedCurrentState.end());
-		for (const auto& state : sortedCurrentState)
-			currentKey += state + ',';
-		std::string currentDFAState = allStates[currentKey]; // stores the current dfa state
-		for (const char& symbol : dfa.m_alphabet) { // iterates over dfa's alphabet
-			std::unordered_set<std::string> canBeReached = nfa.getTransitionStates(currentState, symbol); // stores all reachable nfa stated for the current dfa state with symbol
-			std::unordered_set<std::string> closure;
-			for (const auto& state : canBeReached) { // iterates over the reachable states
-				auto stateClosure = nfa.lambdaClosure(state); // storea all lambda closures from state
-				closure.insert(stateClosure.begin(), stateClosure.end()); 
-			}
-			if (!closure.empty()) { // checks if there are reachable nfa states includinf lambda transition
-				std::string closureKey;
-				std::vector<std::string> sortedClosure(closure.begin(), closure.end());
-				std::sort(sortedClosure.begin(), sortedClosure.end());
-				for (const auto& state : sortedClosure)
-					closureKey += state + ',';
-				if (allStates.find(closureKey) == allStates.end()) { // checks if closureKey already exists in allStates
-					std::string newState = "q" + std::to_string(newcounter++) + "'"; // creates a new dfa state
-					allStates[closureKey] = newState; // map the closureKey to the newly created dfa state
-					dfa.m_states.insert(newState);
-					newStates.push(closure); // the closure set is added to the queue and will be processed further to discover new dfa states
-				}
-				if (dfa.m_transitionFunctions.count(currentDFAState)) { // checks if the current dfa state already has transitions defined
-					auto& transitions = dfa.m_transitionFunctions[currentDFAState];
-					if (transitions.count(symbol)) // checks if there is already a transition for the current symbol
-						transitions[symbol].insert(allStates[closureKey]); // adds the new state to the set of target states for that symbol
-					else 
-						dfa.m_transitionFunctions[currentDFAState][symbol] = { allStates[closureKey] }; // creates new transition function from current dfa state with symbol to a set of target states
-				}
-				else 
-					dfa.m_transitionFunctions[currentDFAState][symbol] = { allStates[closureKey] };
-			}
+/// <param name="compiled"></param>
+/// <returns></returns>
+Automaton Automaton::fromCompiledDFA(const CompiledDFA& compiled) {
+	Automaton dfa;
+	auto name = [](CompiledDFA::State state) { return "q" + std::to_string(state - 1) + "'"; };
+	dfa.m_alphabet.insert(compiled.alphabet().begin(), compiled.alphabet().end());
+	for (CompiledDFA::State state = 1; state < compiled.stateCount(); state++) {
+		dfa.m_states.insert(name(state));
+		if (compiled.isAccepting(state))
+			dfa.m_finalStates.insert(name(state));
+		for (unsigned int byte = 1; byte < 256; byte++) { // a symbol of the compiled dfa may stand for a range of bytes; '\0' is lambda here
+			const CompiledDFA::State target = compiled.next(state, static_cast<unsigned char>(byte));
+			if (target == CompiledDFA::kDeadState)
+				continue;
+			dfa.m_alphabet.insert(static_cast<char>(byte));
+			dfa.m_transitionFunctions[name(state)][static_cast<char>(byte)] = { name(target) };
 		}
-		for (const auto& nfaState : currentState) // iterates over each nfa state in the current dfa state set
-			if (nfa.m_finalStates.count(nfaState)) { // checks if the nfa state is a final state
-				dfa.m_finalStates.insert(currentDFAState); // marks the current dfa state set as final
-				break;
-			}
 	}
+	if (compiled.initialState() != CompiledDFA::kDeadState)
+		dfa.m_initialState = name(compiled.initialState());
+	return dfa;
 }
 
 /// <summary>
@@ -414,15 +583,7 @@ void Automaton::processTransitionsAndFinalStates(const Automaton& nfa, std::queu
 /// <param name="nfa"></param>
 /// <returns></returns>
 Automaton Automaton::convertToDFA(const Automaton& nfa) const {
-	int newcounter = 0; // number of states in dfa, used to generate unique names
-	Automaton dfa;
-	dfa.m_alphabet = nfa.m_alphabet; // copies the alphabet from nfa
-
-	std::queue<std::unordered_set<std::string>> newStates; // keeps sets of nfa state; each set represents a possble state in the dfa, which corresponds to a subset of nfa states
-	std::unordered_map<std::string, std::string> allStates = createDFAStatesFromNFA(nfa, newStates, newcounter, dfa);
-	processTransitionsAndFinalStates(nfa, newStates, allStates, newcounter, dfa);
-
-	return dfa;
+	return fromCompiledDFA(CompiledDFA::fromNFA(nfa.toIndexedNFA())); // subset construction runs on integer ids and bitsets
 }
 
 /// <summary>
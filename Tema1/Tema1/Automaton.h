@@ -7,6 +7,29 @@
 #include <fstream>
 #include <stack>
 #include <queue>
+#include "CharClass.h"
+#include "CompiledDFA.h"
+#include "IndexedNFA.h"
+#include "NFABuilder.h"
+#include "PositionAutomaton.h"
+#include "RegexTree.h"
+#include "LazyDFA.h"
+#include "Searcher.h"
+#include "StreamMatcher.h"
+#include "PerformanceStats.h"
+
+class ThreadPool;
+
+/// <summary>
+/// how the nfa of an expression is built before determinization
+/// </summary>
+enum class Construction
+{
+	Thompson, // NFABuilder: lambda edges between the fragments, removed again by the lambda closures
+	Glushkov // PositionAutomaton: one state per symbol occurrence and no lambda edges
+};
+
+std::string infixToPostfix(const std::string& s);
 class Automaton
 {
 protected:
@@ -25,22 +48,33 @@ public:
 		std::unordered_set<std::string> finalStates);*/
 
 	Automaton(char symbol, int& counter);
+	Automaton(const CharClass& symbols, int& counter);
 	static Automaton concatenate(const Automaton& a1, const Automaton& a2);
 	static Automaton alternate(const Automaton& a1, const Automaton& a2, int& counter);
 	static Automaton kleeneStar(const Automaton& a, int& counter);
 	static Automaton quantify(const Automaton& a, int& counter);
+	static Automaton optional(const Automaton& a, int& counter);
 	static Automaton createNFA(const std::string& polishForm);
 
 	std::unordered_set<std::string> lambdaClosure(const std::string& state) const;
 	Automaton convertToDFA(const Automaton& nfa) const;
-	std::unordered_map<std::string, std::string> createDFAStatesFromNFA(const Automaton& nfa, std::queue<std::unordered_set<std::string>>& newStates, int& newcounter, Automaton& dfa) const;
-	void processTransitionsAndFinalStates(const Automaton& nfa, std::queue<std::unordered_set<std::string>>& newStates, std::unordered_map<std::string, std::string>& allStates, int& newcounter, Automaton& dfa) const;
+	IndexedNFA toIndexedNFA() const;
+	static Automaton fromCompiledDFA(const CompiledDFA& compiled);
 	std::unordered_set<std::string> getTransitionStates(const std::unordered_set<std::string>& states, char c) const;
 
+	std::size_t stateCount() const { return m_states.size(); }
 	static void printDFA(const Automaton& automaton,std::ofstream& fout);
 	bool verifyAutomaton(const Automaton& dfa) const;
 	void checkWord(const std::string& word) const;
-	static Automaton buildDFA(const std::string& expr);
+	static Automaton buildDFA(const std::string& expr, bool minimize = false, MinimizationStats* stats = nullptr, Construction construction = Construction::Thompson);
+	CompiledDFA compile() const;
+	static IndexedNFA buildIndexedNFA(const std::string& expr, Construction construction = Construction::Thompson);
+	static CompiledDFA buildCompiledDFA(const std::string& expr, bool minimize = false, MinimizationStats* stats = nullptr, ThreadPool* pool = nullptr,
+		Construction construction = Construction::Thompson);
+	static LazyDFA buildLazyDFA(const std::string& expr, std::size_t memoryBudget = LazyDFA::kDefaultMemoryBudget);
+	static Searcher buildSearcher(const std::string& expr);
+	static StreamPattern buildStreamPattern(const std::string& expr);
+	static SimplificationStats measureSimplification(const std::string& expr);
 
 	friend std::ostream& operator<<(std::ostream& os, const Automaton& automaton);
 };
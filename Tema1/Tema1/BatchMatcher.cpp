@@ -0,0 +1,81 @@
+#include "BatchMatcher.h"
+#include <algorithm>
+#include <cstring>
+
+/// <summary>
+/// classifies a list of words; the words are cut in blocks of kWordsPerTask and each task fills its own bitmap words
+/// </summary>
+/// <param name="dfa"></param>
+/// <param name="words"></param>
+/// <param name="pool"></param>
+/// <returns></returns>
+std::vector<std::uint64_t> BatchMatcher::classify(const CompiledDFA& dfa, std::span<const std::string_view> words, ThreadPool& pool) {
+	std::vector<std::uint64_t> bitmap((words.size() + 63) / 64, 0);
+	const std::size_t taskCount = (words.size() + kWordsPerTask - 1) / kWordsPerTask;
+	pool.run(taskCount, [&](std::size_t task) {
+		const std::size_t begin = task * kWordsPerTask;
+		const std::size_t end = std::min(words.size(), begin + kWordsPerTask);
+		for (std::size_t i = begin; i < end; i++)
+			if (dfa.matches(words[i]))
+				bitmap[i >> 6] |= std::uint64_t(1) << (i & 63);
+	});
+	return bitmap;
+}
+
+/// <summary>
+/// classifies every line of a newline separated text (a trailing \r is ignored). The text is cut in one slice per
+/// thread at line boundaries; every slice gets its own bitmap, and the bitmaps are joined at the end since the
+/// number of lines in each slice is only known after matching it
+/// </summary>
+/// <param name="dfa"></param>
+/// <param name="text"></param>
+/// <param name="pool"></param>
+/// <param name="lineCount">receives the number of lines</param>
+/// <returns></returns>
+std::vector<std::uint64_t> BatchMatcher::classifyLines(const CompiledDFA& dfa, std::string_view text, ThreadPool& pool, std::size_t& lineCount) {
+	const std::size_t sliceCount = std::max<std::size_t>(1, std::min(pool.threadCount() * 4, text.size() / 4096));
+	std::vector<std::size_t> sliceStart(sliceCount + 1, text.size());
+	sliceStart[0] = 0;
+	for (std::size_t slice = 1; slice < sliceCount; slice++) { // moves every cut to the beginning of the next line
+		std::size_t cut = std::max(sliceStart[slice - 1], text.size() / sliceCount * slice);
+		const void* newline = cut < text.size() ? std::memchr(text.data() + cut, '\n', text.size() - cut) : nullptr;
+		sliceStart[slice] = newline ? static_cast<const char*>(newline) - text.data() + 1 : text.size();
+	}
+
+	std::vector<std::vector<std::uint64_t>> sliceBits(sliceCount);
+	std::vector<std::size_t> sliceLines(sliceCount, 0);
+	pool.run(sliceCount, [&](std::size_t slice) {
+		std::vector<std::uint64_t>& bits = sliceBits[slice];
+		std::size_t lines = 0;
+		for (std::size_t position = sliceStart[slice]; position < sliceStart[slice + 1]; lines++) {
+			const void* newline = std::memchr(text.data() + position, '\n', sliceStart[slice + 1] - position);
+			std::size_t end = newline ? static_cast<const char*>(newline) - text.data() : sliceStart[slice + 1];
+			const std::size_t next = newline ? end + 1 : end;
+			if (end > position && text[end - 1] == '\r')
+				end--;
+			if ((lines & 63) == 0)
+				bits.push_back(0);
+			if (dfa.matches(text.substr(position, end - position)))
+				bits.back() |= std::uint64_t(1) << (lines & 63);
+			position = next;
+		}
+		sliceLines[slice] = lines;
+	});
+
+	lineCount = 0;
+	for (const std::size_t lines : sliceLines)
+		lineCount += lines;
+	std::vector<std::uint64_t> bitmap((lineCount + 63) / 64, 0);
+	std::size_t offset = 0;
+	for (std::size_t slice = 0; slice < sliceCount; slice++) { // appends every slice's bits at its line offset
+		for (std::size_t i = 0; i < sliceBits[slice].size(); i++) {
+			const std::uint64_t word = sliceBits[slice][i];
+			const std::size_t bit = offset + i * 64;
+			bitmap[bit >> 6] |= word << (bit & 63);
+			if ((bit & 63) != 0 && (bit >> 6) + 1 < bitmap.size())
+				bitmap[(bit >> 6) + 1] |= word >> (64 - (bit & 63));
+		}
+		offset += sliceLines[slice];
+	}
+	return bitmap;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+#include "CompiledDFA.h"
+#include "ThreadPool.h"
+
+/// <summary>
+/// classifies many words against one dfa in parallel; the result is a bitmap where bit i (word i / 64, bit i % 64)
+/// is set if word i is accepted. The dfa is only read, so the threads share it without locks and every thread
+/// writes its own part of the output.
+/// </summary>
+class BatchMatcher
+{
+public:
+	static constexpr std::size_t kWordsPerTask = 64 * 1024; // a multiple of 64, so no two tasks write the same bitmap word
+
+	static std::vector<std::uint64_t> classify(const CompiledDFA& dfa, std::span<const std::string_view> words, ThreadPool& pool);
+	static std::vector<std::uint64_t> classifyLines(const CompiledDFA& dfa, std::string_view text, ThreadPool& pool, std::size_t& lineCount);
+
+	static bool isSet(const std::vector<std::uint64_t>& bitmap, std::size_t index) { return (bitmap[index >> 6] >> (index & 63)) & 1; }
+};
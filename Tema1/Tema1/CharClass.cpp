@@ -0,0 +1,156 @@
+#include "CharClass.h"
+#include <algorithm>
+#include <array>
+
+CharClass::CharClass(char symbol) {
+	const unsigned char byte = static_cast<unsigned char>(symbol);
+	m_ranges.push_back({ byte, byte });
+}
+
+/// <summary>
+/// adds the bytes first..last, merging the ranges that overlap or touch the new one
+/// </summary>
+/// <param name="first"></param>
+/// <param name="last"></param>
+void CharClass::add(unsigned char first, unsigned char last) {
+	auto it = std::lower_bound(m_ranges.begin(), m_ranges.end(), first, [](const Range& range, unsigned char byte) {
+		return range.last + 1 < byte; // ranges ending right before first are merged too
+	});
+	Range merged{ first, last };
+	auto end = it;
+	for (; end != m_ranges.end() && end->first <= last + 1; ++end) {
+		merged.first = std::min(merged.first, end->first);
+		merged.last = std::max(merged.last, end->last);
+	}
+	it = m_ranges.erase(it, end);
+	m_ranges.insert(it, merged);
+}
+
+CharClass CharClass::complement() const {
+	CharClass result;
+	unsigned int next = 0; // first byte not known to be in the set
+	for (const Range& range : m_ranges) {
+		if (range.first > next)
+			result.m_ranges.push_back({ static_cast<unsigned char>(next), static_cast<unsigned char>(range.first - 1) });
+		next = range.last + 1u;
+	}
+	if (next <= 255)
+		result.m_ranges.push_back({ static_cast<unsigned char>(next), 255 });
+	return result;
+}
+
+bool CharClass::contains(unsigned char byte) const {
+	auto it = std::lower_bound(m_ranges.begin(), m_ranges.end(), byte, [](const Range& range, unsigned char b) { return range.last < b; });
+	return it != m_ranges.end() && it->first <= byte;
+}
+
+/// <summary>
+/// position one past the operand starting at position: the next byte, or the whole bracket class. An unterminated
+/// class runs to the end of the expression
+/// </summary>
+/// <param name="expression"></param>
+/// <param name="position"></param>
+/// <returns></returns>
+std::size_t CharClass::operandEnd(const std::string& expression, std::size_t position) {
+	if (expression[position] != '[')
+		return position + 1;
+	std::size_t i = position + 1;
+	if (i < expression.size() && expression[i] == '^')
+		i++;
+	if (i < expression.size() && expression[i] == ']') // literal ], not the end of the class
+		i++;
+	const std::size_t close = expression.find(']', i);
+	return close == std::string::npos ? expression.size() : close + 1;
+}
+
+/// <summary>
+/// reads the operand expression[position, end) as returned by operandEnd; returns false for an unterminated class
+/// or a range whose ends are in the wrong order
+/// </summary>
+/// <param name="expression"></param>
+/// <param name="position"></param>
+/// <param name="end"></param>
+/// <param name="result"></param>
+/// <returns></returns>
+bool CharClass::parse(const std::string& expression, std::size_t position, std::size_t end, CharClass& result) {
+	result = CharClass();
+	if (expression[position] != '[') {
+		result = CharClass(expression[position]);
+		return true;
+	}
+	if (end - position < 3 || expression[end - 1] != ']')
+		return false;
+	std::size_t i = position + 1;
+	const bool negated = expression[i] == '^';
+	if (negated)
+		i++;
+	const std::size_t close = end - 1;
+	if (i >= close) // [^] has no symbols, so its ] cannot close it
+		return false;
+	while (i < close) {
+		const unsigned char first = static_cast<unsigned char>(expression[i]);
+		if (i + 2 < close && expression[i + 1] == '-') { // a - before the closing ] is literal
+			const unsigned char last = static_cast<unsigned char>(expression[i + 2]);
+			if (last < first)
+				return false;
+			result.add(first, last);
+			i += 3;
+		}
+		else {
+			result.add(first, first);
+			i++;
+		}
+	}
+	if (negated)
+		result = result.complement();
+	return true;
+}
+
+/// <summary>
+/// splits the bytes used by the classes into the fewest ranges such that every class is a union of them; these
+/// ranges are the symbols of the automaton, so determinization works on them instead of on single bytes. alphabet
+/// gets the first byte of every range and rangeEnds its last one, and symbolsOf[k] the symbols class k is made of.
+/// Returns false if there would be more than kMaxSymbols symbols
+/// </summary>
+/// <param name="classes"></param>
+/// <param name="alphabet"></param>
+/// <param name="rangeEnds"></param>
+/// <param name="symbolsOf"></param>
+/// <returns></returns>
+bool CharClass::partition(const std::vector<CharClass>& classes, std::string& alphabet, std::string& rangeEnds, std::vector<std::string>& symbolsOf) {
+	std::array<int, 257> coverage{}; // +1 where a range starts, -1 right after it ends
+	std::array<bool, 257> boundary{}; // a symbol starts at this byte
+	for (const CharClass& charClass : classes)
+		for (const Range& range : charClass.m_ranges) {
+			coverage[range.first]++;
+			coverage[range.last + 1]--;
+			boundary[range.first] = boundary[range.last + 1] = true;
+		}
+	alphabet.clear();
+	rangeEnds.clear();
+	int covered = 0;
+	for (std::size_t byte = 0; byte < 256; byte++) {
+		covered += coverage[byte];
+		if (covered == 0)
+			continue;
+		if (boundary[byte]) {
+			alphabet += static_cast<char>(byte);
+			rangeEnds += static_cast<char>(byte);
+		}
+		else
+			rangeEnds.back() = static_cast<char>(byte);
+	}
+	if (alphabet.size() > kMaxSymbols)
+		return false;
+
+	symbolsOf.assign(classes.size(), std::string());
+	for (std::size_t k = 0; k < classes.size(); k++)
+		for (const Range& range : classes[k].m_ranges) {
+			auto it = std::lower_bound(alphabet.begin(), alphabet.end(), range.first, [](char symbol, unsigned char byte) {
+				return static_cast<unsigned char>(symbol) < byte;
+			});
+			for (; it != alphabet.end() && static_cast<unsigned char>(*it) <= range.last; ++it)
+				symbolsOf[k] += *it;
+		}
+	return true;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// set of bytes an operand of an expression stands for, kept as sorted ranges that neither overlap nor touch. An
+/// operand is a single symbol or a bracket class: [a-z0-9_] lists symbols and ranges, [^0-9] takes the complement,
+/// and a ] right after [ or [^ or a - at either end is taken literally
+/// </summary>
+class CharClass
+{
+public:
+	struct Range {
+		unsigned char first;
+		unsigned char last;
+	};
+
+	static constexpr std::size_t kMaxSymbols = 255; // dfa byte classes are 8 bit and class 0 is every other byte
+
+protected:
+	std::vector<Range> m_ranges;
+
+public:
+	CharClass() = default;
+	explicit CharClass(char symbol);
+
+	void add(unsigned char first, unsigned char last);
+	CharClass complement() const;
+	bool contains(unsigned char byte) const;
+
+	bool empty() const { return m_ranges.empty(); }
+	const std::vector<Range>& ranges() const { return m_ranges; }
+
+	static std::size_t operandEnd(const std::string& expression, std::size_t position);
+	static bool parse(const std::string& expression, std::size_t position, std::size_t end, CharClass& result);
+	static bool partition(const std::vector<CharClass>& classes, std::string& alphabet, std::string& rangeEnds, std::vector<std::string>& symbolsOf);
+};
@@ -0,0 +1,113 @@
+#include "CompileCache.h"
+#include "Automaton.h"
+#include "CharClass.h"
+#include <cctype>
+
+namespace {
+	std::string removeSpaces(const std::string& expr) {
+		std::string compact;
+		for (std::size_t i = 0; i < expr.size(); i++)
+			if (expr[i] == '[') { // spaces inside a class are symbols
+				const std::size_t end = CharClass::operandEnd(expr, i);
+				compact.append(expr, i, end - i);
+				i = end - 1;
+			}
+			else if (!std::isspace(static_cast<unsigned char>(expr[i])))
+				compact += expr[i];
+		return compact;
+	}
+}
+
+/// <summary>
+/// key of an expression: its simplified postfix form without whitespace, so different spacing, redundant parentheses
+/// and forms the RegexTree rewrites make equal (a|a, (a*)*) share an entry
+/// </summary>
+/// <param name="expr"></param>
+/// <returns></returns>
+std::string CompileCache::normalize(const std::string& expr) {
+	return RegexTree::simplify(infixToPostfix(removeSpaces(expr)));
+}
+
+/// <summary>
+/// returns the compiled dfa of the expression, building it on a miss
+/// </summary>
+/// <param name="expr"></param>
+/// <returns></returns>
+CompileCache::DFAPointer CompileCache::get(const std::string& expr) {
+	const std::string key = normalize(expr);
+	std::promise<DFAPointer> promise;
+	std::shared_future<DFAPointer> pending;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (auto it = m_entries.find(key); it != m_entries.end()) {
+			m_counters.hits++;
+			m_lru.splice(m_lru.begin(), m_lru, it->second.lruPosition);
+			pending = it->second.result;
+		}
+		else {
+			m_counters.misses++;
+			m_lru.push_front(key);
+			Entry& entry = m_entries[key];
+			entry.result = promise.get_future().share();
+			entry.lruPosition = m_lru.begin();
+		}
+	}
+	if (pending.valid())
+		return pending.get(); // waits outside the lock if another thread is still building it
+
+	DFAPointer dfa;
+	try {
+		dfa = std::make_shared<const CompiledDFA>(Automaton::buildCompiledDFA(removeSpaces(expr), true)); // built outside the lock
+	}
+	catch (...) {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_lru.erase(m_entries[key].lruPosition);
+			m_entries.erase(key);
+		}
+		promise.set_exception(std::current_exception());
+		throw;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		Entry& entry = m_entries[key];
+		entry.bytes = dfa->memoryUsage() + key.capacity();
+		entry.ready = true;
+		m_bytesUsed += entry.bytes;
+		evict();
+	}
+	promise.set_value(dfa);
+	return dfa;
+}
+
+/// <summary>
+/// drops built entries from the least recently used end until the cache fits its budget; callers keep
+/// the dfas they already hold, since entries are shared pointers
+/// </summary>
+void CompileCache::evict() {
+	for (auto it = m_lru.end(); m_bytesUsed > m_byteBudget && it != m_lru.begin();) {
+		--it;
+		Entry& entry = m_entries.at(*it);
+		if (!entry.ready)
+			continue;
+		m_bytesUsed -= entry.bytes;
+		m_counters.evictions++;
+		m_entries.erase(*it);
+		it = m_lru.erase(it);
+	}
+}
+
+CompileCache::Counters CompileCache::counters() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_counters;
+}
+
+std::size_t CompileCache::bytesUsed() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_bytesUsed;
+}
+
+std::size_t CompileCache::size() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_entries.size();
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "CompiledDFA.h"
+
+/// <summary>
+/// thread safe cache of minimized dfas keyed by the normalized expression. Entries are shared and immutable,
+/// the least recently used ones are evicted once their total size goes over the byte budget, and concurrent
+/// requests for an expression that is still being compiled wait for that single build instead of starting their own
+/// </summary>
+class CompileCache
+{
+public:
+	using DFAPointer = std::shared_ptr<const CompiledDFA>;
+	static constexpr std::size_t kDefaultByteBudget = 64 << 20;
+
+	struct Counters
+	{
+		std::size_t hits = 0; // includes requests that waited for a build started by another thread
+		std::size_t misses = 0;
+		std::size_t evictions = 0;
+	};
+
+protected:
+	struct Entry
+	{
+		std::shared_future<DFAPointer> result;
+		std::size_t bytes = 0;
+		bool ready = false; // only built entries can be evicted
+		std::list<std::string>::iterator lruPosition;
+	};
+
+	mutable std::mutex m_mutex;
+	std::unordered_map<std::string, Entry> m_entries;
+	std::list<std::string> m_lru; // most recently used first
+	std::size_t m_byteBudget;
+	std::size_t m_bytesUsed = 0;
+	Counters m_counters;
+
+	void evict();
+
+public:
+	explicit CompileCache(std::size_t byteBudget = kDefaultByteBudget) : m_byteBudget(byteBudget) {}
+
+	static std::string normalize(const std::string& expr);
+
+	DFAPointer get(const std::string& expr);
+	Counters counters() const;
+	std::size_t bytesUsed() const;
+	std::size_t size() const;
+};
@@ -0,0 +1,630 @@
+#include "CompiledDFA.h"
+#include "IndexedNFA.h"
+#include "DFAFile.h"
+#include "MappedDFA.h"
+#include "PerformanceStats.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <queue>
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define TEMA1_SSE2
+#endif
+
+/// <summary>
+/// creates a dfa that only has the dead state and rejects everything
+/// </summary>
+CompiledDFA::CompiledDFA()
+	: m_transitions(1, kDeadState), m_accepting(1, 0) {
+}
+
+/// <summary>
+/// creates a dfa with stateCount states (the dead state included) whose transitions all lead to the dead state;
+/// every symbol of the alphabet starts in its own class, the rest of the bytes share class 0
+/// </summary>
+/// <param name="alphabet"></param>
+/// <param name="stateCount"></param>
+/// <param name="initialState"></param>
+CompiledDFA::CompiledDFA(const std::string& alphabet, std::size_t stateCount, State initialState)
+	: m_alphabet(alphabet), m_stateCount(std::max<std::size_t>(stateCount, 1)), m_initialState(initialState) {
+	std::sort(m_alphabet.begin(), m_alphabet.end());
+	m_alphabet.erase(std::unique(m_alphabet.begin(), m_alphabet.end()), m_alphabet.end());
+	for (const char symbol : m_alphabet)
+		m_classOf[static_cast<unsigned char>(symbol)] = static_cast<std::uint8_t>(m_classCount++);
+	m_transitions.assign(m_stateCount * m_classCount, kDeadState);
+	m_accepting.assign(m_stateCount, 0);
+}
+
+void CompiledDFA::setTransition(State from, char symbol, State to) {
+	m_transitions[from * m_classCount + m_classOf[static_cast<unsigned char>(symbol)]] = to;
+	m_acceleration.clear(); // out of date until computeAcceleration runs again
+	m_accelerated = false;
+}
+
+void CompiledDFA::setAccepting(State state) {
+	m_accepting[state] = 1;
+}
+
+/// <summary>
+/// appends a state whose transitions all lead to the dead state
+/// </summary>
+/// <returns></returns>
+CompiledDFA::State CompiledDFA::addState() {
+	m_transitions.resize(m_transitions.size() + m_classCount, kDeadState);
+	m_accepting.push_back(0);
+	m_acceleration.clear();
+	m_accelerated = false;
+	return static_cast<State>(m_stateCount++);
+}
+
+/// <summary>
+/// puts the other bytes every symbol of the nfa stands for in the class of the symbol
+/// </summary>
+/// <param name="nfa"></param>
+void CompiledDFA::addSymbolRanges(const IndexedNFA& nfa) {
+	for (const char symbol : nfa.alphabet())
+		for (unsigned int byte = static_cast<unsigned char>(symbol) + 1u; byte <= nfa.rangeEnd(symbol); byte++)
+			m_classOf[byte] = m_classOf[static_cast<unsigned char>(symbol)];
+}
+
+/// <summary>
+/// subset construction over the integer nfa; every dfa state is a set of nfa states kept in a StateSetTable,
+/// so deciding if a set was already seen costs one hash over its words; an unanchored dfa behaves as if the
+/// expression was prefixed by any string: the start closure is added to every state, so a match can begin anywhere
+/// </summary>
+/// <param name="nfa"></param>
+/// <param name="unanchored"></param>
+/// <param name="onState">if given, called once for every dfa state with the set of nfa states it stands for</param>
+/// <returns></returns>
+CompiledDFA CompiledDFA::fromNFA(const IndexedNFA& nfa, bool unanchored, const std::function<void(State, const StateSet&)>& onState) {
+	STATS_PHASE(SubsetConstruction);
+	STATS_ADD(nfaStates, nfa.stateCount());
+	STATS_ADD(nfaTransitions, nfa.transitionCount());
+	CompiledDFA dfa(nfa.alphabet(), 1, kDeadState); // only the dead state for now, the rest are added as they are discovered
+	dfa.addSymbolRanges(nfa);
+	StateSetTable allStates(nfa.stateCount()); // set id k is dfa state k + 1
+	StateSet current(nfa.stateCount());
+	std::vector<StateSet> bySymbol(nfa.alphabet().size(), StateSet(nfa.stateCount()));
+
+	current.insert(nfa.initialState());
+	nfa.lambdaClosure(current); // the start state is the lambda closure of the nfa's initial state
+	const StateSet startClosure = current;
+	allStates.intern(current);
+	dfa.m_initialState = dfa.addState();
+
+	for (std::uint32_t id = 0; id < allStates.size(); id++) { // ids are handed out in discovery order, so the table doubles as the queue
+		allStates.load(id, current);
+		const State from = id + 1;
+		if (unanchored)
+			dfa.m_transitions[from * dfa.m_classCount] = dfa.m_initialState; // a byte outside the alphabet only restarts the search
+		nfa.getTransitionStates(current, bySymbol);
+		for (std::size_t i = 0; i < dfa.m_alphabet.size(); i++) {
+			StateSet& reached = bySymbol[i];
+			nfa.lambdaClosure(reached);
+			if (unanchored)
+				reached.unite(startClosure);
+			else if (reached.empty())
+				continue; // stays on the dead state
+			auto [target, inserted] = allStates.intern(reached);
+			if (inserted)
+				dfa.addState();
+			dfa.m_transitions[from * dfa.m_classCount + i + 1] = target + 1; // symbol i of the alphabet is class i + 1
+		}
+		if (current.intersects(nfa.finalStates())) // final if it contains a final nfa state
+			dfa.m_accepting[from] = 1;
+		if (onState)
+			onState(from, current);
+	}
+	STATS_ADD(dfaStates, dfa.m_stateCount - 1);
+	STATS_ADD(dfaTransitions, std::count_if(dfa.m_transitions.begin(), dfa.m_transitions.end(), [](State target) { return target != kDeadState; }));
+	dfa.compressClasses();
+	dfa.computeAcceleration();
+	return dfa;
+}
+
+/// <summary>
+/// subset construction on every thread of the pool, one breadth first level at a time: the sets discovered in the
+/// previous level are split into tasks, whose successors are interned in a sharded table and become the next level.
+/// Which thread finds a set first depends on scheduling, so the states are renumbered afterwards in the breadth first
+/// order fromNFA uses; the result is the same dfa fromNFA would build
+/// </summary>
+/// <param name="nfa"></param>
+/// <param name="pool"></param>
+/// <param name="unanchored">same as for fromNFA</param>
+/// <returns></returns>
+CompiledDFA CompiledDFA::fromNFAParallel(const IndexedNFA& nfa, ThreadPool& pool, bool unanchored) {
+	if (pool.threadCount() == 1)
+		return fromNFA(nfa, unanchored);
+	STATS_PHASE(SubsetConstruction);
+	STATS_ADD(nfaStates, nfa.stateCount());
+	STATS_ADD(nfaTransitions, nfa.transitionCount());
+	constexpr std::size_t kSetsPerTask = 32;
+	constexpr std::uint64_t kDeadKey = UINT64_MAX;
+	const std::string& alphabet = nfa.alphabet();
+	const std::size_t symbolCount = alphabet.size();
+	const std::size_t wordsPerSet = (nfa.stateCount() + 63) / 64;
+
+	ShardedStateSetTable allStates(nfa.stateCount());
+	StateSet start(nfa.stateCount());
+	start.insert(nfa.initialState());
+	nfa.lambdaClosure(start);
+	const StateSet startClosure = start;
+	const std::uint64_t startKey = allStates.intern(start).first;
+
+	std::vector<std::uint64_t> keys; // key of every set, in the order the levels processed them
+	std::vector<std::uint64_t> targets; // symbolCount successor keys per processed set
+	std::vector<std::uint8_t> accepting; // one flag per processed set
+	std::vector<std::uint64_t> levelKeys = { startKey };
+	std::vector<std::uint64_t> levelWords(start.words(), start.words() + wordsPerSet);
+	PerformanceStats* const stats = PerformanceStats::current(); // the workers have no stats scope of their own
+	while (!levelKeys.empty()) {
+		const std::size_t base = keys.size();
+		const std::size_t count = levelKeys.size();
+		keys.insert(keys.end(), levelKeys.begin(), levelKeys.end());
+		targets.resize(targets.size() + count * symbolCount);
+		accepting.resize(base + count);
+		const std::size_t taskCount = (count + kSetsPerTask - 1) / kSetsPerTask;
+		std::vector<std::vector<std::uint64_t>> newKeys(taskCount), newWords(taskCount); // next level, per task
+		std::vector<PerformanceStats> taskStats(PerformanceStats::kEnabled && stats != nullptr ? taskCount : 0);
+		pool.run(taskCount, [&](std::size_t task) {
+			// a task on a worker counts into its own object, added to the caller's once the level is done; the
+			// calling thread keeps counting into the caller's object directly
+			std::optional<StatsScope> scope;
+			std::optional<PhaseTimer> timer;
+			if (!taskStats.empty() && PerformanceStats::current() != stats) {
+				scope.emplace(taskStats[task]);
+				timer.emplace(PerformanceStats::Phase::SubsetConstruction);
+			}
+			StateSet current(nfa.stateCount());
+			std::vector<StateSet> bySymbol(symbolCount, StateSet(nfa.stateCount()));
+			for (std::size_t i = task * kSetsPerTask; i < std::min(count, (task + 1) * kSetsPerTask); i++) {
+				std::copy_n(&levelWords[i * wordsPerSet], wordsPerSet, current.words());
+				accepting[base + i] = current.intersects(nfa.finalStates()) ? 1 : 0;
+				nfa.getTransitionStates(current, bySymbol);
+				for (std::size_t s = 0; s < symbolCount; s++) {
+					StateSet& reached = bySymbol[s];
+					nfa.lambdaClosure(reached);
+					if (unanchored)
+						reached.unite(startClosure);
+					else if (reached.empty()) {
+						targets[(base + i) * symbolCount + s] = kDeadKey;
+						continue;
+					}
+					const auto [key, inserted] = allStates.intern(reached);
+					targets[(base + i) * symbolCount + s] = key;
+					if (inserted) {
+						newKeys[task].push_back(key);
+						newWords[task].insert(newWords[task].end(), reached.words(), reached.words() + wordsPerSet);
+					}
+				}
+			}
+		});
+		for (const PerformanceStats& counted : taskStats)
+			stats->addCounters(counted);
+		levelKeys.clear();
+		levelWords.clear();
+		for (std::size_t task = 0; task < taskCount; task++) {
+			levelKeys.insert(levelKeys.end(), newKeys[task].begin(), newKeys[task].end());
+			levelWords.insert(levelWords.end(), newWords[task].begin(), newWords[task].end());
+		}
+	}
+
+	// every set was processed exactly once; renumber them in breadth first order from the start set
+	const std::vector<std::size_t> bases = allStates.denseBases();
+	auto dense = [&](std::uint64_t key) { return bases[ShardedStateSetTable::shardOf(key)] + ShardedStateSetTable::idOf(key); };
+	std::vector<std::size_t> rowOf(keys.size());
+	for (std::size_t row = 0; row < keys.size(); row++)
+		rowOf[dense(keys[row])] = row;
+	const State unassigned = UINT32_MAX;
+	std::vector<State> stateOf(keys.size(), unassigned);
+	std::vector<std::size_t> order = { dense(startKey) };
+	CompiledDFA dfa(alphabet, 1, kDeadState);
+	dfa.addSymbolRanges(nfa);
+	stateOf[order[0]] = dfa.m_initialState = dfa.addState();
+	for (std::size_t i = 0; i < order.size(); i++) {
+		const std::size_t row = rowOf[order[i]];
+		const State from = stateOf[order[i]];
+		if (unanchored)
+			dfa.m_transitions[from * dfa.m_classCount] = dfa.m_initialState;
+		for (std::size_t s = 0; s < symbolCount; s++) {
+			const std::uint64_t key = targets[row * symbolCount + s];
+			if (key == kDeadKey)
+				continue;
+			const std::size_t target = dense(key);
+			if (stateOf[target] == unassigned) {
+				stateOf[target] = dfa.addState();
+				order.push_back(target);
+			}
+			dfa.m_transitions[from * dfa.m_classCount + s + 1] = stateOf[target];
+		}
+		dfa.m_accepting[from] = accepting[row];
+	}
+	STATS_ADD(dfaStates, dfa.m_stateCount - 1);
+	STATS_ADD(dfaTransitions, std::count_if(dfa.m_transitions.begin(), dfa.m_transitions.end(), [](State target) { return target != kDeadState; }));
+	dfa.compressClasses();
+	dfa.computeAcceleration();
+	return dfa;
+}
+
+/// <summary>
+/// merges the states that accept the same words
+/// </summary>
+/// <param name="stats"></param>
+/// <returns></returns>
+CompiledDFA CompiledDFA::minimize(MinimizationStats* stats) const {
+	return minimize(std::vector<std::uint32_t>(m_accepting.begin(), m_accepting.end()), nullptr, stats);
+}
+
+/// <summary>
+/// hopcroft's partition refinement: starts from the blocks of states with equal labels and splits blocks by their
+/// predecessors, always queueing the smaller half of a split, which gives O(n * k * log n) for n states and k byte
+/// classes; states with different labels are never merged. The dead state's block stays state 0 and the rest are
+/// numbered in breadth first order from the initial state
+/// </summary>
+/// <param name="labels">one per state; final and non final states must have different labels</param>
+/// <param name="newStateOf">if given, receives the new state of every old state</param>
+/// <param name="stats"></param>
+/// <returns></returns>
+CompiledDFA CompiledDFA::minimize(const std::vector<std::uint32_t>& labels, std::vector<State>* newStateOf, MinimizationStats* stats) const {
+	STATS_PHASE(Minimization);
+	const std::size_t n = m_stateCount;
+	const std::size_t k = m_classCount;
+
+	// predecessors of every state on every class, stored as one flat array per class
+	std::vector<std::size_t> inverseStart(k * (n + 1), 0);
+	std::vector<State> inverse(k * n);
+	for (std::size_t cls = 0; cls < k; cls++) {
+		std::size_t* start = &inverseStart[cls * (n + 1)];
+		for (std::size_t state = 0; state < n; state++)
+			start[m_transitions[state * k + cls] + 1]++;
+		for (std::size_t state = 0; state < n; state++)
+			start[state + 1] += start[state];
+		std::vector<std::size_t> fill(start, start + n);
+		for (std::size_t state = 0; state < n; state++)
+			inverse[cls * n + fill[m_transitions[state * k + cls]]++] = static_cast<State>(state);
+	}
+
+	// partition: the states of block b are elements[first[b] .. first[b] + size[b]), the marked ones at the front
+	std::vector<State> elements(n);
+	std::vector<std::size_t> location(n), blockOf(n), first, size, marked;
+	for (std::size_t state = 0; state < n; state++)
+		elements[state] = static_cast<State>(state);
+	std::stable_sort(elements.begin(), elements.end(), [&](State a, State b) { return labels[a] < labels[b]; });
+	for (std::size_t i = 0; i < n; i++) { // one block per run of equal labels
+		location[elements[i]] = i;
+		if (i == 0 || labels[elements[i]] != labels[elements[i - 1]]) {
+			first.push_back(i);
+			size.push_back(0);
+		}
+		size.back()++;
+	}
+	marked.assign(first.size(), 0);
+	for (std::size_t block = 0; block < first.size(); block++)
+		for (std::size_t i = first[block]; i < first[block] + size[block]; i++)
+			blockOf[elements[i]] = block;
+
+	std::queue<std::pair<std::size_t, std::size_t>> waiting; // (block, class) splitters
+	std::vector<std::uint8_t> isWaiting(n * k, 0);
+	auto addSplitter = [&](std::size_t block, std::size_t cls) {
+		if (!isWaiting[block * k + cls]) {
+			isWaiting[block * k + cls] = 1;
+			waiting.push({ block, cls });
+		}
+	};
+	const std::size_t largest = std::max_element(size.begin(), size.end()) - size.begin();
+	for (std::size_t block = 0; block < first.size(); block++) // every initial block but the largest one
+		if (block != largest)
+			for (std::size_t cls = 0; cls < k; cls++)
+				addSplitter(block, cls);
+
+	std::vector<State> predecessors;
+	std::vector<std::size_t> touched;
+	while (!waiting.empty()) {
+		auto [splitter, cls] = waiting.front();
+		waiting.pop();
+		isWaiting[splitter * k + cls] = 0;
+
+		predecessors.clear(); // collected before any split, since the splitter itself may be split below
+		const std::size_t* start = &inverseStart[cls * (n + 1)];
+		for (std::size_t i = first[splitter]; i < first[splitter] + size[splitter]; i++) {
+			const State target = elements[i];
+			predecessors.insert(predecessors.end(), &inverse[cls * n + start[target]], &inverse[cls * n + start[target + 1]]);
+		}
+
+		touched.clear();
+		for (const State state : predecessors) { // moves every predecessor to the marked front of its block
+			const std::size_t block = blockOf[state];
+			const std::size_t boundary = first[block] + marked[block];
+			if (location[state] < boundary)
+				continue; // already marked
+			const State other = elements[boundary];
+			std::swap(elements[location[state]], elements[boundary]);
+			location[other] = location[state];
+			location[state] = boundary;
+			if (marked[block]++ == 0)
+				touched.push_back(block);
+		}
+
+		for (const std::size_t block : touched) {
+			const std::size_t markedCount = marked[block];
+			marked[block] = 0;
+			if (markedCount == size[block])
+				continue; // every state of the block has a predecessor edge, nothing to split
+			const std::size_t newBlock = first.size(); // the marked part becomes a new block
+			first.push_back(first[block]);
+			size.push_back(markedCount);
+			marked.push_back(0);
+			first[block] += markedCount;
+			size[block] -= markedCount;
+			for (std::size_t i = first[newBlock]; i < first[newBlock] + size[newBlock]; i++)
+				blockOf[elements[i]] = newBlock;
+			for (std::size_t c = 0; c < k; c++)
+				if (isWaiting[block * k + c])
+					addSplitter(newBlock, c); // both halves have to be processed
+				else
+					addSplitter(size[newBlock] <= size[block] ? newBlock : block, c); // the smaller half is enough
+		}
+	}
+
+	// renumbers the blocks: the dead state's block is 0, the others in breadth first order from the initial state
+	const std::size_t unassigned = SIZE_MAX;
+	std::vector<std::size_t> newId(first.size(), unassigned);
+	newId[blockOf[kDeadState]] = kDeadState;
+	std::vector<State> representatives = { kDeadState };
+	std::queue<std::size_t> toVisit;
+	if (newId[blockOf[m_initialState]] == unassigned) {
+		newId[blockOf[m_initialState]] = 1;
+		representatives.push_back(m_initialState);
+		toVisit.push(blockOf[m_initialState]);
+	}
+	while (!toVisit.empty()) {
+		const State representative = elements[first[toVisit.front()]];
+		toVisit.pop();
+		for (std::size_t c = 0; c < k; c++) {
+			const std::size_t target = blockOf[m_transitions[representative * k + c]];
+			if (newId[target] == unassigned) {
+				newId[target] = representatives.size();
+				representatives.push_back(elements[first[target]]);
+				toVisit.push(target);
+			}
+		}
+	}
+
+	CompiledDFA result;
+	result.m_alphabet = m_alphabet;
+	result.m_classOf = m_classOf;
+	result.m_classCount = k;
+	result.m_stateCount = representatives.size();
+	result.m_initialState = static_cast<State>(newId[blockOf[m_initialState]]);
+	result.m_transitions.assign(result.m_stateCount * k, kDeadState);
+	result.m_accepting.assign(result.m_stateCount, 0);
+	for (std::size_t state = 0; state < representatives.size(); state++) {
+		const State representative = representatives[state];
+		result.m_accepting[state] = m_accepting[representative];
+		for (std::size_t c = 0; c < k; c++)
+			result.m_transitions[state * k + c] = static_cast<State>(newId[blockOf[m_transitions[representative * k + c]]]);
+	}
+	result.compressClasses(); // merged states can make more columns identical
+	result.computeAcceleration();
+	if (newStateOf) {
+		newStateOf->assign(n, kDeadState);
+		for (std::size_t state = 0; state < n; state++)
+			if (newId[blockOf[state]] != unassigned)
+				(*newStateOf)[state] = static_cast<State>(newId[blockOf[state]]);
+	}
+	if (stats) {
+		stats->statesBefore = m_stateCount - 1;
+		stats->statesAfter = result.m_stateCount - 1;
+	}
+	STATS_ADD(minimizedStates, result.m_stateCount - 1);
+	return result;
+}
+
+/// <summary>
+/// merges the byte classes whose columns are identical in every row, so the table only keeps distinct columns
+/// </summary>
+void CompiledDFA::compressClasses() {
+	std::map<std::vector<State>, std::uint8_t> columns; // column contents -> new class id
+	std::vector<std::uint8_t> remap(m_classCount);
+	for (std::size_t cls = 0; cls < m_classCount; cls++) {
+		std::vector<State> column(m_stateCount);
+		for (std::size_t state = 0; state < m_stateCount; state++)
+			column[state] = m_transitions[state * m_classCount + cls];
+		auto [it, inserted] = columns.emplace(std::move(column), static_cast<std::uint8_t>(columns.size()));
+		remap[cls] = it->second; // class 0 is always seen first, so it keeps id 0
+	}
+	const std::size_t newClassCount = columns.size();
+	if (newClassCount == m_classCount)
+		return;
+	std::vector<State> transitions(m_stateCount * newClassCount);
+	for (std::size_t state = 0; state < m_stateCount; state++)
+		for (std::size_t cls = 0; cls < m_classCount; cls++)
+			transitions[state * newClassCount + remap[cls]] = m_transitions[state * m_classCount + cls];
+	for (auto& cls : m_classOf)
+		cls = remap[cls];
+	m_transitions = std::move(transitions);
+	m_classCount = newClassCount;
+}
+
+/// <summary>
+/// finds the states that loop on themselves on every byte except at most kMaxExitBytes of them, like the state of
+/// [^x]* or the initial state of an unanchored search for a rare symbol, and keeps their exit bytes, so walking
+/// such a state can jump to the next exit byte instead of looking up every byte. The dead state exits on no byte
+/// </summary>
+void CompiledDFA::computeAcceleration() {
+	std::vector<std::size_t> classSize(m_classCount, 0); // bytes in every class
+	for (const std::uint8_t cls : m_classOf)
+		classSize[cls]++;
+	m_acceleration.assign(m_stateCount, Acceleration());
+	m_accelerated = false;
+	for (State state = 0; state < m_stateCount; state++) {
+		const State* row = &m_transitions[state * m_classCount];
+		std::size_t exitCount = 0;
+		for (std::size_t cls = 0; cls < m_classCount && exitCount <= kMaxExitBytes; cls++)
+			if (row[cls] != state)
+				exitCount += classSize[cls];
+		if (exitCount > kMaxExitBytes)
+			continue;
+		Acceleration& acceleration = m_acceleration[state];
+		acceleration.count = static_cast<std::uint8_t>(exitCount);
+		std::size_t found = 0;
+		for (unsigned int byte = 0; byte < 256 && found < exitCount; byte++)
+			if (row[m_classOf[byte]] != state)
+				acceleration.bytes[found++] = static_cast<unsigned char>(byte);
+		for (; found > 0 && found < kMaxExitBytes; found++)
+			acceleration.bytes[found] = acceleration.bytes[found - 1];
+		if (state != kDeadState)
+			m_accelerated = true;
+	}
+}
+
+std::size_t CompiledDFA::accelerableStateCount() const {
+	return std::count_if(m_acceleration.begin(), m_acceleration.end(), [](const Acceleration& acceleration) {
+		return acceleration.count != Acceleration::kNotAccelerable;
+	});
+}
+
+/// <summary>
+/// position of the first byte of data[from, to) on which the accelerable state does not loop, or to if there is none;
+/// a single exit byte is memchr, more are compared 16 bytes at a time where SSE2 is available
+/// </summary>
+/// <param name="state"></param>
+/// <param name="data"></param>
+/// <param name="from"></param>
+/// <param name="to"></param>
+/// <returns></returns>
+std::size_t CompiledDFA::findExit(State state, const char* data, std::size_t from, std::size_t to) const {
+	const Acceleration& acceleration = m_acceleration[state];
+	if (acceleration.count == 0 || from >= to)
+		return to;
+	if (acceleration.count == 1) {
+		const void* found = std::memchr(data + from, acceleration.bytes[0], to - from);
+		return found ? static_cast<const char*>(found) - data : to;
+	}
+	std::size_t i = from;
+#ifdef TEMA1_SSE2
+	const __m128i first = _mm_set1_epi8(static_cast<char>(acceleration.bytes[0]));
+	const __m128i second = _mm_set1_epi8(static_cast<char>(acceleration.bytes[1]));
+	const __m128i third = _mm_set1_epi8(static_cast<char>(acceleration.bytes[2]));
+	for (; i + 16 <= to; i += 16) {
+		const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+		const __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, first), _mm_cmpeq_epi8(block, second)), _mm_cmpeq_epi8(block, third));
+		const unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(hits));
+		if (mask != 0)
+			return i + std::countr_zero(mask);
+	}
+#endif
+	for (; i < to; i++) {
+		const unsigned char byte = static_cast<unsigned char>(data[i]);
+		if (byte == acceleration.bytes[0] || byte == acceleration.bytes[1] || byte == acceleration.bytes[2])
+			return i;
+	}
+	return to;
+}
+
+/// <summary>
+/// runs the dfa over text from state and returns the state it ends in. Without accelerable states this is one class
+/// lookup and one table load per byte; with them, a byte that keeps an accelerable state where it is makes the walk
+/// jump to the next exit byte of that state
+/// </summary>
+/// <param name="state"></param>
+/// <param name="text"></param>
+/// <returns></returns>
+CompiledDFA::State CompiledDFA::walk(State state, std::string_view text) const {
+	const State* table = m_transitions.data();
+	const std::size_t classCount = m_classCount;
+	if (!m_accelerated) {
+		for (const char symbol : text)
+			state = table[state * classCount + m_classOf[static_cast<unsigned char>(symbol)]]; // the dead state loops on itself, so no branch is needed
+		return state;
+	}
+	const char* data = text.data();
+	for (std::size_t i = 0; i < text.size();) {
+		const State next = table[state * classCount + m_classOf[static_cast<unsigned char>(data[i++])]];
+		if (next == state && m_acceleration[state].count != Acceleration::kNotAccelerable)
+			i = findExit(state, data, i, text.size());
+		state = next;
+	}
+	return state;
+}
+
+/// <summary>
+/// checks if the whole word is accepted; no allocation
+/// </summary>
+/// <param name="word"></param>
+/// <returns></returns>
+bool CompiledDFA::matches(std::string_view word) const {
+	STATS_PHASE(Matching);
+	const State state = walk(m_initialState, word);
+	STATS_ADD(bytesScanned, word.size());
+	STATS_ADD(matchesFound, m_accepting[state]);
+	return m_accepting[state] != 0;
+}
+
+/// <summary>
+/// writes the dfa in the binary format described in DFAFile.h; returns false if the file could not be written
+/// </summary>
+/// <param name="path"></param>
+/// <returns></returns>
+bool CompiledDFA::save(const std::string& path) const {
+	auto align = [](std::uint64_t offset) { return (offset + 7) & ~std::uint64_t(7); };
+	DFAFileHeader header{};
+	std::memcpy(header.magic, DFAFileHeader::kMagic, sizeof(header.magic));
+	header.version = DFAFileHeader::kVersion;
+	header.endianMarker = DFAFileHeader::kEndianMarker;
+	header.stateCount = static_cast<std::uint32_t>(m_stateCount);
+	header.classCount = static_cast<std::uint32_t>(m_classCount);
+	header.initialState = m_initialState;
+	header.alphabetSize = static_cast<std::uint32_t>(m_alphabet.size());
+	header.alphabetOffset = align(sizeof(DFAFileHeader));
+	header.classMapOffset = align(header.alphabetOffset + m_alphabet.size());
+	header.acceptingOffset = align(header.classMapOffset + m_classOf.size());
+	header.transitionsOffset = align(header.acceptingOffset + (m_stateCount + 7) / 8);
+	header.fileSize = header.transitionsOffset + m_transitions.size() * sizeof(State);
+
+	std::vector<char> file(header.fileSize, 0); // built in memory and written at once
+	std::vector<std::uint8_t> accepting((m_stateCount + 7) / 8, 0);
+	for (std::size_t state = 0; state < m_stateCount; state++)
+		if (m_accepting[state])
+			accepting[state >> 3] |= std::uint8_t(1) << (state & 7);
+	std::memcpy(file.data(), &header, sizeof(header));
+	std::memcpy(file.data() + header.alphabetOffset, m_alphabet.data(), m_alphabet.size());
+	std::memcpy(file.data() + header.classMapOffset, m_classOf.data(), m_classOf.size());
+	std::memcpy(file.data() + header.acceptingOffset, accepting.data(), accepting.size());
+	std::memcpy(file.data() + header.transitionsOffset, m_transitions.data(), m_transitions.size() * sizeof(State));
+
+	std::ofstream fout(path, std::ios::binary | std::ios::trunc);
+	if (!fout.is_open())
+		return false;
+	fout.write(file.data(), file.size());
+	return static_cast<bool>(fout);
+}
+
+/// <summary>
+/// reads a file written by save into dfa; returns false if it cannot be read or is not valid.
+/// To match without copying the table, open the file with MappedDFA instead
+/// </summary>
+/// <param name="path"></param>
+/// <param name="dfa"></param>
+/// <returns></returns>
+bool CompiledDFA::load(const std::string& path, CompiledDFA& dfa) {
+	MappedDFA mapped(path);
+	if (!mapped.isOpen())
+		return false;
+	dfa.m_alphabet = std::string(mapped.alphabet());
+	dfa.m_stateCount = mapped.stateCount();
+	dfa.m_classCount = mapped.classCount();
+	dfa.m_initialState = mapped.initialState();
+	std::copy_n(mapped.classMap(), dfa.m_classOf.size(), dfa.m_classOf.begin());
+	dfa.m_transitions.assign(mapped.transitions(), mapped.transitions() + dfa.m_stateCount * dfa.m_classCount);
+	dfa.m_accepting.assign(dfa.m_stateCount, 0);
+	for (State state = 0; state < dfa.m_stateCount; state++)
+		dfa.m_accepting[state] = mapped.isAccepting(state) ? 1 : 0;
+	dfa.computeAcceleration();
+	return true;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <array>
+#include <functional>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class IndexedNFA;
+class StateSet;
+class ThreadPool;
+
+/// <summary>
+/// number of states (the dead state not included) before and after CompiledDFA::minimize
+/// </summary>
+struct MinimizationStats
+{
+	std::size_t statesBefore = 0;
+	std::size_t statesAfter = 0;
+};
+
+/// <summary>
+/// integer indexed form of a dfa used for matching: states are numbered 0..n-1 (0 is the dead state)
+/// and transitions live in one row-major table indexed by state * classCount + byte class
+/// </summary>
+class CompiledDFA
+{
+public:
+	using State = std::uint32_t;
+	static constexpr State kDeadState = 0; // absorbing state every missing transition leads to
+	static constexpr std::size_t kMaxExitBytes = 3; // a state that leaves on more bytes than this is walked byte by byte
+
+protected:
+	/// <summary>
+	/// bytes on which a state does not loop on itself; count is kNotAccelerable if there are more than kMaxExitBytes
+	/// </summary>
+	struct Acceleration
+	{
+		static constexpr std::uint8_t kNotAccelerable = 0xFF;
+
+		std::uint8_t count = kNotAccelerable;
+		std::array<unsigned char, kMaxExitBytes> bytes{}; // unused entries repeat the last exit byte
+	};
+
+	std::string m_alphabet; // sorted symbols of the source automaton
+	std::array<std::uint8_t, 256> m_classOf{}; // byte -> equivalence class; class 0 holds every byte outside the alphabet
+	std::size_t m_classCount = 1;
+	std::size_t m_stateCount = 1;
+	State m_initialState = kDeadState;
+	std::vector<State> m_transitions; // m_stateCount rows of m_classCount columns
+	std::vector<std::uint8_t> m_accepting; // one flag per state
+	std::vector<Acceleration> m_acceleration; // one per state, empty until computeAcceleration
+	bool m_accelerated = false; // some state other than the dead one is accelerable
+
+	State addState();
+	void addSymbolRanges(const IndexedNFA& nfa);
+
+public:
+	CompiledDFA();
+	CompiledDFA(const std::string& alphabet, std::size_t stateCount, State initialState);
+
+	void setTransition(State from, char symbol, State to);
+	void setAccepting(State state);
+	void compressClasses();
+	void computeAcceleration();
+	static CompiledDFA fromNFA(const IndexedNFA& nfa, bool unanchored = false, const std::function<void(State, const StateSet&)>& onState = {});
+	static CompiledDFA fromNFAParallel(const IndexedNFA& nfa, ThreadPool& pool, bool unanchored = false);
+	CompiledDFA minimize(MinimizationStats* stats = nullptr) const;
+	CompiledDFA minimize(const std::vector<std::uint32_t>& labels, std::vector<State>* newStateOf, MinimizationStats* stats = nullptr) const;
+
+	bool matches(std::string_view word) const;
+	State walk(State state, std::string_view text) const;
+	std::size_t findExit(State state, const char* data, std::size_t from, std::size_t to) const;
+
+	bool save(const std::string& path) const;
+	static bool load(const std::string& path, CompiledDFA& dfa);
+
+	State next(State state, unsigned char byte) const { return m_transitions[state * m_classCount + m_classOf[byte]]; }
+	bool isAccepting(State state) const { return m_accepting[state] != 0; }
+	bool isAccelerable(State state) const { return state < m_acceleration.size() && m_acceleration[state].count != Acceleration::kNotAccelerable; }
+	std::size_t accelerableStateCount() const;
+	State initialState() const { return m_initialState; }
+	std::size_t stateCount() const { return m_stateCount; }
+	std::size_t classCount() const { return m_classCount; }
+	const std::string& alphabet() const { return m_alphabet; }
+	std::size_t memoryUsage() const { return sizeof(CompiledDFA) + m_alphabet.capacity() + m_transitions.capacity() * sizeof(State) + m_accepting.capacity()
+		+ m_acceleration.capacity() * sizeof(Acceleration); }
+};
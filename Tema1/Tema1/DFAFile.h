@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+
+/// <summary>
+/// layout of a compiled dfa saved with CompiledDFA::save: this header, then the sections at the offsets it lists,
+/// each starting on an 8 byte boundary. Numbers are stored in the byte order of the machine that wrote the file;
+/// endianMarker tells a reader with the other order to reject it.
+///   alphabet     alphabetSize chars
+///   class map    256 bytes, byte -> class
+///   accepting    (stateCount + 7) / 8 bytes, bit s of byte s / 8 is set if state s is final
+///   transitions  stateCount * classCount uint32, row-major
+/// </summary>
+struct DFAFileHeader
+{
+	static constexpr char kMagic[8] = { 'T', 'E', 'M', 'A', '1', 'D', 'F', 'A' };
+	static constexpr std::uint32_t kVersion = 1;
+	static constexpr std::uint32_t kEndianMarker = 0x01020304;
+
+	char magic[8];
+	std::uint32_t version;
+	std::uint32_t endianMarker;
+	std::uint32_t stateCount;
+	std::uint32_t classCount;
+	std::uint32_t initialState;
+	std::uint32_t alphabetSize;
+	std::uint64_t alphabetOffset;
+	std::uint64_t classMapOffset;
+	std::uint64_t acceptingOffset;
+	std::uint64_t transitionsOffset;
+	std::uint64_t fileSize;
+};
@@ -0,0 +1,268 @@
+#include "IndexedNFA.h"
+#include <algorithm>
+#include "PerformanceStats.h"
+
+IndexedNFA::IndexedNFA(const std::string& alphabet, std::size_t stateCount, StateId initialState)
+	: m_alphabet(alphabet), m_initialState(initialState), m_edges(stateCount), m_lambdaEdges(stateCount), m_finalStates(stateCount) {
+	std::sort(m_alphabet.begin(), m_alphabet.end());
+	m_alphabet.erase(std::unique(m_alphabet.begin(), m_alphabet.end()), m_alphabet.end());
+	for (std::size_t i = 0; i < m_alphabet.size(); i++) {
+		m_symbolIndex[static_cast<unsigned char>(m_alphabet[i])] = static_cast<std::uint8_t>(i);
+		m_rangeEnd[static_cast<unsigned char>(m_alphabet[i])] = static_cast<unsigned char>(m_alphabet[i]);
+	}
+}
+
+void IndexedNFA::addEdge(StateId from, char symbol, StateId to) {
+	m_edges[from].push_back({ symbol, to });
+}
+
+void IndexedNFA::addLambdaEdge(StateId from, StateId to) {
+	m_lambdaEdges[from].push_back(to);
+	m_lambdaEdgeCount++;
+	m_closureRow.clear(); // the precomputed closures are out of date
+	m_closures.clear();
+}
+
+void IndexedNFA::setFinal(StateId state) {
+	m_finalStates.insert(state);
+}
+
+/// <summary>
+/// makes a symbol of the alphabet stand for the bytes from itself to last (see CharClass::partition); the ranges of
+/// the symbols must not overlap
+/// </summary>
+/// <param name="symbol"></param>
+/// <param name="last"></param>
+void IndexedNFA::setRangeEnd(char symbol, char last) {
+	m_rangeEnd[static_cast<unsigned char>(symbol)] = static_cast<unsigned char>(last);
+}
+
+/// <summary>
+/// computes the lambda closure of every state once, so that lambdaClosure only has to unite precomputed rows.
+/// The lambda edges are condensed into strongly connected components (iterative tarjan), whose states share one
+/// closure; tarjan finishes a component after every component it reaches, so in that order the closure of a
+/// component is its own states united with the already computed closures of its successors. States without
+/// lambda edges get no row at all, their closure is themselves. Skipped if the table would exceed kMaxClosureTableBytes
+/// </summary>
+void IndexedNFA::computeClosures() {
+	const std::size_t n = stateCount();
+	const std::uint32_t unvisited = UINT32_MAX;
+	std::vector<std::uint32_t> index(n, unvisited), low(n, 0), component(n, unvisited);
+	std::vector<StateId> stack; // states of the components that are not finished yet
+	std::vector<std::pair<StateId, std::size_t>> path; // dfs path: state and the next lambda edge to follow
+	std::uint32_t nextIndex = 0, componentCount = 0;
+	for (StateId root = 0; root < n; root++) {
+		if (index[root] != unvisited)
+			continue;
+		index[root] = low[root] = nextIndex++;
+		stack.push_back(root);
+		path.push_back({ root, 0 });
+		while (!path.empty()) {
+			auto& [state, edge] = path.back();
+			if (edge < m_lambdaEdges[state].size()) {
+				const StateId target = m_lambdaEdges[state][edge++];
+				if (index[target] == unvisited) {
+					index[target] = low[target] = nextIndex++;
+					stack.push_back(target);
+					path.push_back({ target, 0 });
+				}
+				else if (component[target] == unvisited) // still on the stack
+					low[state] = std::min(low[state], index[target]);
+				continue;
+			}
+			const StateId finished = state;
+			path.pop_back();
+			if (!path.empty())
+				low[path.back().first] = std::min(low[path.back().first], low[finished]);
+			if (low[finished] == index[finished]) {
+				StateId member;
+				do {
+					member = stack.back();
+					stack.pop_back();
+					component[member] = componentCount;
+				} while (member != finished);
+				componentCount++;
+			}
+		}
+	}
+
+	// states grouped by component, and a row for every component that has lambda edges
+	std::vector<std::uint32_t> memberStart(componentCount + 1, 0);
+	for (StateId state = 0; state < n; state++)
+		memberStart[component[state] + 1]++;
+	for (std::uint32_t c = 0; c < componentCount; c++)
+		memberStart[c + 1] += memberStart[c];
+	std::vector<StateId> members(n);
+	std::vector<std::uint32_t> fill(memberStart.begin(), memberStart.end() - 1);
+	for (StateId state = 0; state < n; state++)
+		members[fill[component[state]]++] = state;
+	std::vector<std::uint32_t> rowOf(componentCount, kNoRow);
+	std::uint32_t rowCount = 0;
+	for (StateId state = 0; state < n; state++)
+		if (!m_lambdaEdges[state].empty() && rowOf[component[state]] == kNoRow)
+			rowOf[component[state]] = rowCount++;
+
+	const std::size_t wordsPerRow = m_finalStates.wordCount();
+	m_closureRow.clear();
+	m_closures.clear();
+	if (rowCount == 0 || rowCount * wordsPerRow * sizeof(std::uint64_t) > kMaxClosureTableBytes)
+		return;
+	m_closures.assign(rowCount * wordsPerRow, 0);
+	for (std::uint32_t c = 0; c < componentCount; c++) {
+		if (rowOf[c] == kNoRow)
+			continue;
+		std::uint64_t* row = &m_closures[rowOf[c] * wordsPerRow];
+		for (std::uint32_t i = memberStart[c]; i < memberStart[c + 1]; i++) {
+			const StateId member = members[i];
+			row[member >> 6] |= std::uint64_t(1) << (member & 63);
+			for (const StateId target : m_lambdaEdges[member]) {
+				const std::uint32_t targetComponent = component[target];
+				if (targetComponent == c)
+					continue;
+				if (rowOf[targetComponent] == kNoRow) {
+					row[target >> 6] |= std::uint64_t(1) << (target & 63);
+					continue;
+				}
+				const std::uint64_t* targetRow = &m_closures[rowOf[targetComponent] * wordsPerRow];
+				for (std::size_t w = 0; w < wordsPerRow; w++)
+					row[w] |= targetRow[w];
+			}
+		}
+	}
+	m_closureRow.resize(n);
+	for (StateId state = 0; state < n; state++)
+		m_closureRow[state] = rowOf[component[state]];
+}
+
+/// <summary>
+/// extends the set in place with every state reachable through lambda transitions; reads the rows of computeClosures
+/// when they exist and runs a dfs otherwise
+/// </summary>
+/// <param name="states"></param>
+void IndexedNFA::lambdaClosure(StateSet& states) const {
+	STATS_ADD(closureCalls, 1);
+	if (m_lambdaEdgeCount == 0)
+		return;
+	if (!m_closures.empty()) {
+		const std::size_t wordsPerRow = states.wordCount();
+		std::uint64_t* words = states.words();
+		// the rows are closed, so a state added here only brings in states that are already in: the rows are ORed
+		// straight into the set, and expanding an added state again changes nothing
+		for (std::size_t i = 0; i < wordsPerRow; i++)
+			for (std::uint64_t word = words[i]; word != 0; word &= word - 1) {
+				const std::uint32_t row = m_closureRow[i * 64 + StateSet::countTrailingZeros(word)];
+				if (row == kNoRow)
+					continue;
+				const std::uint64_t* closure = &m_closures[row * wordsPerRow];
+				for (std::size_t w = 0; w < wordsPerRow; w++)
+					words[w] |= closure[w];
+			}
+		return;
+	}
+	std::vector<StateId> stack; // dfs over the lambda edges, seeded with the whole set
+	states.forEach([&](std::size_t state) { stack.push_back(static_cast<StateId>(state)); });
+	while (!stack.empty()) {
+		const StateId current = stack.back();
+		stack.pop_back();
+		for (const StateId target : m_lambdaEdges[current])
+			if (!states.contains(target)) {
+				states.insert(target);
+				stack.push_back(target);
+			}
+	}
+}
+
+/// <summary>
+/// stores in result the states reachable from the given set with one transition on symbol
+/// </summary>
+/// <param name="states"></param>
+/// <param name="symbol"></param>
+/// <param name="result"></param>
+void IndexedNFA::getTransitionStates(const StateSet& states, char symbol, StateSet& result) const {
+	result.clear();
+	states.forEach([&](std::size_t state) {
+		for (const Edge& edge : m_edges[state])
+			if (edge.symbol == symbol)
+				result.insert(edge.target);
+	});
+}
+
+/// <summary>
+/// the successors on every symbol in one pass over the edges: bySymbol[i] receives the states reachable from the
+/// set with one transition on alphabet()[i]; bySymbol must hold alphabet().size() sets of stateCount() states
+/// </summary>
+/// <param name="states"></param>
+/// <param name="bySymbol"></param>
+void IndexedNFA::getTransitionStates(const StateSet& states, std::vector<StateSet>& bySymbol) const {
+	for (StateSet& result : bySymbol)
+		result.clear();
+	states.forEach([&](std::size_t state) {
+		for (const Edge& edge : m_edges[state])
+			bySymbol[m_symbolIndex[static_cast<unsigned char>(edge.symbol)]].insert(edge.target);
+	});
+}
+
+/// <summary>
+/// nfa of the reversed language: every edge is flipped, a new initial state has lambda edges to the old
+/// final states and the old initial state becomes the only final state
+/// </summary>
+/// <returns></returns>
+IndexedNFA IndexedNFA::reversed() const {
+	const StateId newInitial = static_cast<StateId>(stateCount());
+	IndexedNFA result(m_alphabet, stateCount() + 1, newInitial);
+	result.m_rangeEnd = m_rangeEnd;
+	for (StateId state = 0; state < stateCount(); state++) {
+		for (const Edge& edge : m_edges[state])
+			result.addEdge(edge.target, edge.symbol, state);
+		for (const StateId target : m_lambdaEdges[state])
+			result.addLambdaEdge(target, state);
+	}
+	m_finalStates.forEach([&](std::size_t state) { result.addLambdaEdge(newInitial, static_cast<StateId>(state)); });
+	result.setFinal(m_initialState);
+	result.computeClosures();
+	return result;
+}
+
+/// <summary>
+/// nfa of the reversed prefixes of the language (the words that can be continued into a word of the language), read
+/// backwards: like reversed, but the new initial state also has lambda edges to every state a final state can be
+/// reached from
+/// </summary>
+/// <returns></returns>
+IndexedNFA IndexedNFA::reversedPrefixes() const {
+	IndexedNFA result = reversed();
+	const StateId initial = result.initialState();
+	std::vector<bool> reached(result.stateCount(), false); // reachable in the reversed nfa: can reach a final state here
+	std::vector<StateId> pending{ initial };
+	reached[initial] = true;
+	while (!pending.empty()) {
+		const StateId state = pending.back();
+		pending.pop_back();
+		auto visit = [&](StateId target) {
+			if (!reached[target]) {
+				reached[target] = true;
+				pending.push_back(target);
+			}
+		};
+		for (const Edge& edge : result.m_edges[state])
+			visit(edge.target);
+		for (const StateId target : result.m_lambdaEdges[state])
+			visit(target);
+	}
+	for (StateId state = 0; state < stateCount(); state++)
+		if (reached[state])
+			result.addLambdaEdge(initial, state);
+	result.computeClosures();
+	return result;
+}
+
+/// <summary>
+/// number of symbol and lambda edges
+/// </summary>
+/// <returns></returns>
+std::size_t IndexedNFA::transitionCount() const {
+	std::size_t count = 0;
+	for (StateId state = 0; state < stateCount(); state++)
+		count += m_edges[state].size() + m_lambdaEdges[state].size();
+	return count;
+}
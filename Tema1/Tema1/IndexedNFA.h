@@ -0,0 +1,61 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "StateSetTable.h"
+
+/// <summary>
+/// nfa whose states are the integers 0..n-1, used by the determinization and simulation code
+/// instead of the string named states of Automaton
+/// </summary>
+class IndexedNFA
+{
+public:
+	using StateId = std::uint32_t;
+	struct Edge {
+		char symbol;
+		StateId target;
+	};
+
+protected:
+	std::string m_alphabet; // sorted, without lambda
+	std::array<std::uint8_t, 256> m_symbolIndex{}; // symbol -> its position in m_alphabet
+	std::array<unsigned char, 256> m_rangeEnd{}; // a symbol stands for every byte from itself to its range end
+	std::size_t m_lambdaEdgeCount = 0;
+	StateId m_initialState = 0;
+	std::vector<std::vector<Edge>> m_edges; // symbol transitions of every state
+	std::vector<std::vector<StateId>> m_lambdaEdges; // lambda transitions of every state
+	StateSet m_finalStates;
+	std::vector<std::uint32_t> m_closureRow; // row of every state's lambda closure in m_closures, kNoRow if it has no lambda edges
+	std::vector<std::uint64_t> m_closures; // one bitset row per strongly connected component of the lambda edges, empty if not computed
+
+public:
+	static constexpr std::uint32_t kNoRow = UINT32_MAX;
+	static constexpr std::size_t kMaxClosureTableBytes = std::size_t(64) << 20; // larger tables fall back to a dfs per call
+
+	IndexedNFA() = default;
+	IndexedNFA(const std::string& alphabet, std::size_t stateCount, StateId initialState);
+
+	void addEdge(StateId from, char symbol, StateId to);
+	void addLambdaEdge(StateId from, StateId to);
+	void setFinal(StateId state);
+	void setRangeEnd(char symbol, char last);
+
+	void computeClosures();
+	bool hasClosureTable() const { return !m_closures.empty(); }
+	void lambdaClosure(StateSet& states) const;
+	void getTransitionStates(const StateSet& states, char symbol, StateSet& result) const;
+	void getTransitionStates(const StateSet& states, std::vector<StateSet>& bySymbol) const;
+	IndexedNFA reversed() const;
+	IndexedNFA reversedPrefixes() const;
+	std::size_t transitionCount() const;
+
+	std::size_t stateCount() const { return m_edges.size(); }
+	StateId initialState() const { return m_initialState; }
+	const std::string& alphabet() const { return m_alphabet; }
+	unsigned char rangeEnd(char symbol) const { return m_rangeEnd[static_cast<unsigned char>(symbol)]; }
+	const StateSet& finalStates() const { return m_finalStates; }
+	const std::vector<Edge>& edges(StateId state) const { return m_edges[state]; }
+	const std::vector<StateId>& lambdaEdges(StateId state) const { return m_lambdaEdges[state]; }
+};
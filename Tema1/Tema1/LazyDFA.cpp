@@ -0,0 +1,132 @@
+#include "LazyDFA.h"
+#include "PerformanceStats.h"
+
+/// <summary>
+/// prepares an empty cache for the given nfa; only the start state is determinized up front
+/// </summary>
+/// <param name="nfa"></param>
+/// <param name="memoryBudget"></param>
+LazyDFA::LazyDFA(const IndexedNFA& nfa, std::size_t memoryBudget)
+	: m_nfa(nfa), m_classCount(nfa.alphabet().size() + 1), m_memoryBudget(memoryBudget), m_states(nfa.stateCount()) {
+	for (std::size_t i = 0; i < m_nfa.alphabet().size(); i++) {
+		const char symbol = m_nfa.alphabet()[i];
+		for (unsigned int byte = static_cast<unsigned char>(symbol); byte <= m_nfa.rangeEnd(symbol); byte++) // every byte the symbol stands for
+			m_classOf[byte] = static_cast<std::uint8_t>(i + 1);
+	}
+	// set words, cached hash, two buckets (load factor under one half), transition row and final flag
+	m_bytesPerState = m_states.wordsPerSet() * sizeof(std::uint64_t) + sizeof(std::uint64_t) + 2 * sizeof(std::uint32_t)
+		+ m_classCount * sizeof(State) + 1;
+	flush();
+	m_flushCount = 0;
+}
+
+/// <summary>
+/// interns a set that is not in the cache yet and gives it an empty transition row
+/// </summary>
+/// <param name="set"></param>
+/// <returns></returns>
+LazyDFA::State LazyDFA::addState(const StateSet& set) {
+	const State state = m_states.intern(set).first + 1;
+	m_transitions.resize(m_transitions.size() + m_classCount, kUnknown);
+	m_transitions[state * m_classCount] = kDeadState; // bytes outside the alphabet always kill the match
+	m_accepting.push_back(set.intersects(m_nfa.finalStates()) ? 1 : 0);
+	return state;
+}
+
+/// <summary>
+/// drops every cached state and determinizes the start state again
+/// </summary>
+void LazyDFA::flush() {
+	m_states = StateSetTable(m_nfa.stateCount());
+	m_transitions.assign(m_classCount, kDeadState); // row of the dead state
+	m_accepting.assign(1, 0);
+	StateSet start(m_nfa.stateCount());
+	start.insert(m_nfa.initialState());
+	m_nfa.lambdaClosure(start);
+	m_initialState = addState(start);
+	m_flushCount++;
+}
+
+/// <summary>
+/// computes the transition of a cached state on a class and caches the target; returns kUnknown when the cache had
+/// to be flushed too soon after the previous flush, in which case target holds the nfa states to continue from
+/// </summary>
+/// <param name="from"></param>
+/// <param name="cls"></param>
+/// <param name="position">number of bytes matched so far, over every call</param>
+/// <param name="target"></param>
+/// <returns></returns>
+LazyDFA::State LazyDFA::computeTransition(State from, std::size_t cls, std::size_t position, StateSet& target) {
+	StateSet current(m_nfa.stateCount());
+	m_states.load(from - 1, current);
+	m_nfa.getTransitionStates(current, m_nfa.alphabet()[cls - 1], target);
+	if (target.empty())
+		return m_transitions[from * m_classCount + cls] = kDeadState;
+	m_nfa.lambdaClosure(target);
+	if (const std::uint32_t id = m_states.find(target); id != StateSetTable::kNotFound)
+		return m_transitions[from * m_classCount + cls] = id + 1;
+
+	if ((m_states.size() + 1) * m_bytesPerState > m_memoryBudget) { // no room for another state
+		const std::size_t cached = m_states.size();
+		flush();
+		const bool useful = position - m_bytesAtLastFlush >= kMinBytesPerState * cached;
+		m_bytesAtLastFlush = position;
+		if (!useful || (m_states.size() + 1) * m_bytesPerState > m_memoryBudget)
+			return kUnknown; // the cache is thrashing or too small to hold even two states
+		return addState(target); // the source row was flushed, so the transition itself is not recorded
+	}
+	const State state = addState(target);
+	m_transitions[from * m_classCount + cls] = state;
+	return state;
+}
+
+/// <summary>
+/// plain nfa simulation over the rest of the input, starting from the given set of states
+/// </summary>
+/// <param name="current"></param>
+/// <param name="rest"></param>
+/// <returns></returns>
+bool LazyDFA::simulate(StateSet& current, std::string_view rest) const {
+	StateSet next(m_nfa.stateCount());
+	for (const char byte : rest) {
+		const std::size_t cls = m_classOf[static_cast<unsigned char>(byte)];
+		if (cls == 0)
+			return false;
+		m_nfa.getTransitionStates(current, m_nfa.alphabet()[cls - 1], next); // the edges are labelled with the first byte of their range
+		if (next.empty())
+			return false;
+		m_nfa.lambdaClosure(next);
+		std::swap(current, next);
+	}
+	return current.intersects(m_nfa.finalStates());
+}
+
+/// <summary>
+/// checks if the whole word is accepted, determinizing only the states the word goes through
+/// </summary>
+/// <param name="word"></param>
+/// <returns></returns>
+bool LazyDFA::matches(std::string_view word) {
+	STATS_PHASE(Matching);
+	STATS_ADD(bytesScanned, word.size());
+	State state = m_initialState;
+	StateSet target(m_nfa.stateCount());
+	for (std::size_t i = 0; i < word.size(); i++) {
+		const std::size_t cls = m_classOf[static_cast<unsigned char>(word[i])];
+		State next = m_transitions[state * m_classCount + cls];
+		if (next == kUnknown) {
+			next = computeTransition(state, cls, m_bytesMatched + i, target);
+			if (next == kUnknown) {
+				m_fallbackCount++;
+				m_bytesMatched += word.size();
+				const bool accepted = simulate(target, word.substr(i + 1));
+				STATS_ADD(matchesFound, accepted ? 1 : 0);
+				return accepted;
+			}
+		}
+		state = next;
+	}
+	m_bytesMatched += word.size();
+	STATS_ADD(matchesFound, m_accepting[state]);
+	return m_accepting[state] != 0;
+}
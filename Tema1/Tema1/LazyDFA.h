@@ -0,0 +1,55 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "IndexedNFA.h"
+#include "StateSetTable.h"
+
+/// <summary>
+/// dfa that is determinized on demand while matching: a dfa state (a set of nfa states) and its transitions are
+/// only computed the first time the input reaches them and are kept in a cache bounded by a memory budget;
+/// when the budget is exceeded the cache is flushed, and if flushes come too often the rest of the input is
+/// matched by simulating the nfa directly. Not thread safe, since matching fills the cache.
+/// </summary>
+class LazyDFA
+{
+public:
+	using State = std::uint32_t;
+	static constexpr std::size_t kDefaultMemoryBudget = 1 << 20; // bytes
+	static constexpr std::size_t kMinBytesPerState = 10; // a flush is considered useful if at least this many bytes per cached state were matched since the previous one
+
+protected:
+	static constexpr State kDeadState = 0;
+	static constexpr State kUnknown = UINT32_MAX; // transition not computed yet
+
+	IndexedNFA m_nfa;
+	std::array<std::uint8_t, 256> m_classOf{}; // byte -> class; symbol i of the alphabet is class i + 1, the rest are class 0
+	std::size_t m_classCount;
+	std::size_t m_memoryBudget;
+	std::size_t m_bytesPerState;
+
+	StateSetTable m_states; // set id k is dfa state k + 1
+	std::vector<State> m_transitions; // one row of m_classCount entries per cached state
+	std::vector<std::uint8_t> m_accepting;
+	State m_initialState = kDeadState;
+	std::size_t m_flushCount = 0;
+	std::size_t m_fallbackCount = 0;
+	std::size_t m_bytesMatched = 0; // over every call, used to judge how useful the last flush was
+	std::size_t m_bytesAtLastFlush = 0;
+
+	State addState(const StateSet& set);
+	void flush();
+	State computeTransition(State from, std::size_t cls, std::size_t position, StateSet& target);
+	bool simulate(StateSet& current, std::string_view rest) const;
+
+public:
+	explicit LazyDFA(const IndexedNFA& nfa, std::size_t memoryBudget = kDefaultMemoryBudget);
+
+	bool matches(std::string_view word);
+
+	std::size_t cachedStates() const { return m_states.size(); }
+	std::size_t memoryUsed() const { return m_states.size() * m_bytesPerState; }
+	std::size_t flushCount() const { return m_flushCount; }
+	std::size_t fallbackCount() const { return m_fallbackCount; }
+};
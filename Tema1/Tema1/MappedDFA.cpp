@@ -0,0 +1,69 @@
+#include "MappedDFA.h"
+#include "PerformanceStats.h"
+#include <cstring>
+
+/// <summary>
+/// maps the file and checks it; isOpen() is false if it could not be read or is not a valid dfa file
+/// </summary>
+/// <param name="path"></param>
+MappedDFA::MappedDFA(const std::string& path)
+	: m_file(path) {
+	if (!m_file.isOpen() || !validate(m_file.data(), m_file.size()))
+		return;
+	m_header = reinterpret_cast<const DFAFileHeader*>(m_file.data());
+	m_classOf = reinterpret_cast<const std::uint8_t*>(m_file.data() + m_header->classMapOffset);
+	m_accepting = reinterpret_cast<const std::uint8_t*>(m_file.data() + m_header->acceptingOffset);
+	m_transitions = reinterpret_cast<const State*>(m_file.data() + m_header->transitionsOffset);
+	m_classCount = m_header->classCount;
+}
+
+/// <summary>
+/// checks the header, that every section lies inside the file and that every class and transition target is in range
+/// </summary>
+/// <param name="data">must be 8 byte aligned</param>
+/// <param name="size"></param>
+/// <returns></returns>
+bool MappedDFA::validate(const char* data, std::size_t size) {
+	if (data == nullptr || size < sizeof(DFAFileHeader))
+		return false;
+	const DFAFileHeader& header = *reinterpret_cast<const DFAFileHeader*>(data);
+	if (std::memcmp(header.magic, DFAFileHeader::kMagic, sizeof(header.magic)) != 0 || header.version != DFAFileHeader::kVersion
+		|| header.endianMarker != DFAFileHeader::kEndianMarker || header.fileSize != size)
+		return false;
+	if (header.stateCount == 0 || header.classCount == 0 || header.classCount > 256 || header.initialState >= header.stateCount)
+		return false;
+	auto inside = [&](std::uint64_t offset, std::uint64_t length, std::uint64_t alignment) {
+		return offset % alignment == 0 && offset <= size && length <= size - offset;
+	};
+	const std::uint64_t tableSize = std::uint64_t(header.stateCount) * header.classCount * sizeof(State);
+	if (!inside(header.alphabetOffset, header.alphabetSize, 1) || !inside(header.classMapOffset, 256, 1)
+		|| !inside(header.acceptingOffset, (std::uint64_t(header.stateCount) + 7) / 8, 1) || !inside(header.transitionsOffset, tableSize, alignof(State)))
+		return false;
+	const std::uint8_t* classOf = reinterpret_cast<const std::uint8_t*>(data + header.classMapOffset);
+	for (std::size_t byte = 0; byte < 256; byte++)
+		if (classOf[byte] >= header.classCount)
+			return false;
+	const State* transitions = reinterpret_cast<const State*>(data + header.transitionsOffset);
+	const std::uint64_t entries = std::uint64_t(header.stateCount) * header.classCount;
+	for (std::uint64_t i = 0; i < entries; i++)
+		if (transitions[i] >= header.stateCount)
+			return false;
+	return true;
+}
+
+/// <summary>
+/// checks if the whole word is accepted, reading the mapped table directly
+/// </summary>
+/// <param name="word"></param>
+/// <returns></returns>
+bool MappedDFA::matches(std::string_view word) const {
+	STATS_PHASE(Matching);
+	const State* table = m_transitions;
+	const std::size_t classCount = m_classCount;
+	State state = m_header->initialState;
+	for (const char symbol : word)
+		state = table[state * classCount + m_classOf[static_cast<unsigned char>(symbol)]];
+	STATS_ADD(bytesScanned, word.size());
+	STATS_ADD(matchesFound, isAccepting(state) ? 1 : 0);
+	return isAccepting(state);
+}
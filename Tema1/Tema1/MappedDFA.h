@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "DFAFile.h"
+#include "MappedFile.h"
+
+/// <summary>
+/// dfa matched straight from a file written by CompiledDFA::save: the file is memory-mapped and the table is
+/// used in place, so opening it costs a header check and one pass that validates the transitions
+/// </summary>
+class MappedDFA
+{
+public:
+	using State = std::uint32_t;
+
+protected:
+	MappedFile m_file;
+	const DFAFileHeader* m_header = nullptr;
+	const std::uint8_t* m_classOf = nullptr;
+	const std::uint8_t* m_accepting = nullptr;
+	const State* m_transitions = nullptr;
+	std::size_t m_classCount = 0;
+
+public:
+	MappedDFA() = default;
+	explicit MappedDFA(const std::string& path);
+
+	static bool validate(const char* data, std::size_t size);
+
+	bool isOpen() const { return m_header != nullptr; }
+	bool matches(std::string_view word) const;
+
+	State next(State state, unsigned char byte) const { return m_transitions[state * m_classCount + m_classOf[byte]]; }
+	bool isAccepting(State state) const { return (m_accepting[state >> 3] >> (state & 7)) & 1; }
+	State initialState() const { return m_header->initialState; }
+	std::size_t stateCount() const { return m_header->stateCount; }
+	std::size_t classCount() const { return m_classCount; }
+	const std::uint8_t* classMap() const { return m_classOf; }
+	const State* transitions() const { return m_transitions; }
+	std::string_view alphabet() const { return { m_file.data() + m_header->alphabetOffset, m_header->alphabetSize }; }
+};
@@ -0,0 +1,102 @@
+#include "MappedFile.h"
+#include <utility>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/// <summary>
+/// maps the file at path; isOpen() tells if it worked. An empty file is open with size 0 and no mapping
+/// </summary>
+/// <param name="path"></param>
+MappedFile::MappedFile(const std::string& path) {
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return;
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size)) {
+		CloseHandle(file);
+		return;
+	}
+	m_file = file;
+	m_size = static_cast<std::size_t>(size.QuadPart);
+	m_isOpen = true;
+	if (m_size == 0)
+		return;
+	m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_mapping != nullptr)
+		m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+	if (m_data == nullptr)
+		close();
+#else
+	const int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return;
+	struct stat info;
+	if (fstat(fd, &info) != 0) {
+		::close(fd);
+		return;
+	}
+	m_size = static_cast<std::size_t>(info.st_size);
+	m_isOpen = true;
+	if (m_size > 0) {
+		void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data == MAP_FAILED) {
+			m_isOpen = false;
+			m_size = 0;
+		}
+		else {
+			m_data = static_cast<const char*>(data);
+			madvise(data, m_size, MADV_SEQUENTIAL); // the matchers read front to back
+		}
+	}
+	::close(fd); // the mapping stays valid without the descriptor
+#endif
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+	*this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+	if (this != &other) {
+		close();
+		m_data = std::exchange(other.m_data, nullptr);
+		m_size = std::exchange(other.m_size, 0);
+		m_isOpen = std::exchange(other.m_isOpen, false);
+#ifdef _WIN32
+		m_file = std::exchange(other.m_file, nullptr);
+		m_mapping = std::exchange(other.m_mapping, nullptr);
+#endif
+	}
+	return *this;
+}
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+void MappedFile::close() {
+#ifdef _WIN32
+	if (m_data != nullptr)
+		UnmapViewOfFile(m_data);
+	if (m_mapping != nullptr)
+		CloseHandle(m_mapping);
+	if (m_file != nullptr)
+		CloseHandle(m_file);
+	m_file = nullptr;
+	m_mapping = nullptr;
+#else
+	if (m_data != nullptr)
+		munmap(const_cast<char*>(m_data), m_size);
+#endif
+	m_data = nullptr;
+	m_size = 0;
+	m_isOpen = false;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+/// <summary>
+/// read-only memory mapping of a whole file; the contents are read straight from the page cache without copies
+/// </summary>
+class MappedFile
+{
+protected:
+	const char* m_data = nullptr;
+	std::size_t m_size = 0;
+	bool m_isOpen = false;
+#ifdef _WIN32
+	void* m_file = nullptr;
+	void* m_mapping = nullptr;
+#endif
+
+	void close();
+
+public:
+	MappedFile() = default;
+	explicit MappedFile(const std::string& path);
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+	~MappedFile();
+
+	bool isOpen() const { return m_isOpen; }
+	const char* data() const { return m_data; }
+	std::size_t size() const { return m_size; }
+	std::string_view view() const { return { m_data, m_size }; }
+};
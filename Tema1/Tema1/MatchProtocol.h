@@ -0,0 +1,116 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/// <summary>
+/// framing used by MatchServer on its Unix domain socket. Every request and every response is a 12 byte header
+/// followed by length bytes of payload; numbers are little endian whatever the machine. A response carries the
+/// requestId of its request and may arrive before the answers to requests sent earlier, so a client can keep many
+/// requests in flight on one connection.
+///   Match        payload: words, each a uint32 length and its bytes; response: one byte per word, 1 if accepted
+///   Search       payload: the text; response: a uint64 start and end for each non-overlapping longest match
+///   SearchAll    like Search, with every offset where a match ends and the leftmost start of a match ending there
+///   PatternCount empty payload; response: the number of patterns as a uint32
+/// </summary>
+namespace MatchProtocol
+{
+	enum class Op : std::uint8_t
+	{
+		Match = 1,
+		Search = 2,
+		SearchAll = 3,
+		PatternCount = 4
+	};
+
+	enum class Status : std::uint8_t
+	{
+		Ok = 0,
+		UnknownPattern = 1,
+		UnknownOp = 2,
+		BadPayload = 3 // a word length runs past the end of the payload
+	};
+
+	struct FrameHeader
+	{
+		std::uint32_t length = 0; // payload bytes after the header
+		std::uint32_t requestId = 0;
+		std::uint16_t pattern = 0; // requests: index of the pattern on the server
+		std::uint8_t op = 0; // requests: an Op; responses: the Op they answer
+		std::uint8_t status = 0; // responses: a Status
+	};
+
+	constexpr std::size_t kHeaderSize = 12;
+	constexpr std::uint32_t kMaxPayload = 64 << 20; // a larger frame closes the connection
+	constexpr std::size_t kMaxInFlight = 256; // requests of one connection queued or running; the server stops reading beyond that
+
+	inline void putUint32(char* out, std::uint32_t value) {
+		for (int i = 0; i < 4; i++)
+			out[i] = static_cast<char>(value >> (8 * i));
+	}
+
+	inline std::uint32_t getUint32(const char* in) {
+		std::uint32_t value = 0;
+		for (int i = 0; i < 4; i++)
+			value |= static_cast<std::uint32_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+		return value;
+	}
+
+	inline void appendUint32(std::string& out, std::uint32_t value) {
+		char bytes[4];
+		putUint32(bytes, value);
+		out.append(bytes, 4);
+	}
+
+	inline void appendUint64(std::string& out, std::uint64_t value) {
+		appendUint32(out, static_cast<std::uint32_t>(value));
+		appendUint32(out, static_cast<std::uint32_t>(value >> 32));
+	}
+
+	inline std::uint64_t getUint64(const char* in) {
+		return getUint32(in) | static_cast<std::uint64_t>(getUint32(in + 4)) << 32;
+	}
+
+	inline void encodeHeader(char* out, const FrameHeader& header) {
+		putUint32(out, header.length);
+		putUint32(out + 4, header.requestId);
+		out[8] = static_cast<char>(header.pattern);
+		out[9] = static_cast<char>(header.pattern >> 8);
+		out[10] = static_cast<char>(header.op);
+		out[11] = static_cast<char>(header.status);
+	}
+
+	inline FrameHeader decodeHeader(const char* in) {
+		FrameHeader header;
+		header.length = getUint32(in);
+		header.requestId = getUint32(in + 4);
+		header.pattern = static_cast<std::uint16_t>(static_cast<unsigned char>(in[8]) | static_cast<unsigned char>(in[9]) << 8);
+		header.op = static_cast<std::uint8_t>(in[10]);
+		header.status = static_cast<std::uint8_t>(in[11]);
+		return header;
+	}
+
+	/// <summary>
+	/// adds a word to the payload of a Match request
+	/// </summary>
+	/// <param name="payload"></param>
+	/// <param name="word"></param>
+	inline void appendWord(std::string& payload, std::string_view word) {
+		appendUint32(payload, static_cast<std::uint32_t>(word.size()));
+		payload.append(word);
+	}
+
+	/// <summary>
+	/// header and payload of one frame, ready to be written to the socket
+	/// </summary>
+	/// <param name="header">its length is set from the payload</param>
+	/// <param name="payload"></param>
+	/// <returns></returns>
+	inline std::string frame(FrameHeader header, std::string_view payload) {
+		header.length = static_cast<std::uint32_t>(payload.size());
+		std::string bytes(kHeaderSize, '\0');
+		encodeHeader(bytes.data(), header);
+		bytes.append(payload);
+		return bytes;
+	}
+}
@@ -0,0 +1,274 @@
+#include "MatchServer.h"
+#ifndef _WIN32
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "Automaton.h"
+
+namespace
+{
+#ifdef MSG_NOSIGNAL
+	constexpr int kSendFlags = MSG_NOSIGNAL; // a client that went away is an error code, not a SIGPIPE
+#else
+	constexpr int kSendFlags = 0; // SO_NOSIGPIPE is set on the socket instead
+#endif
+
+	bool readAll(int socket, char* data, std::size_t size) {
+		while (size > 0) {
+			const ssize_t count = ::recv(socket, data, size, 0);
+			if (count < 0 && errno == EINTR)
+				continue;
+			if (count <= 0)
+				return false;
+			data += count;
+			size -= static_cast<std::size_t>(count);
+		}
+		return true;
+	}
+
+	bool writeAll(int socket, const char* data, std::size_t size) {
+		while (size > 0) {
+			const ssize_t count = ::send(socket, data, size, kSendFlags);
+			if (count < 0 && errno == EINTR)
+				continue;
+			if (count <= 0)
+				return false;
+			data += count;
+			size -= static_cast<std::size_t>(count);
+		}
+		return true;
+	}
+}
+
+/// <summary>
+/// compiles every expression (minimized dfa for Match, Searcher for Search) and starts the workers; expression k
+/// is pattern k of the protocol
+/// </summary>
+/// <param name="expressions"></param>
+/// <param name="workerCount"></param>
+MatchServer::MatchServer(const std::vector<std::string>& expressions, std::size_t workerCount) {
+	m_patterns.reserve(expressions.size());
+	for (const std::string& expression : expressions)
+		m_patterns.push_back({ Automaton::buildCompiledDFA(expression, true), Automaton::buildSearcher(expression) });
+	if (workerCount == 0)
+		workerCount = 1;
+	for (std::size_t i = 0; i < workerCount; i++)
+		m_workers.emplace_back(&MatchServer::work, this);
+}
+
+MatchServer::~MatchServer() {
+	if (m_listener >= 0) { // serve was never called
+		::close(m_listener);
+		::unlink(m_path.c_str());
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_queueMutex);
+		m_closingQueue = true;
+	}
+	m_queued.notify_all();
+	for (auto& worker : m_workers)
+		worker.join();
+}
+
+/// <summary>
+/// binds the socket file at path, replacing a stale one left by a previous server; returns false if the path is too
+/// long for a socket address or the socket cannot be created
+/// </summary>
+/// <param name="path"></param>
+/// <returns></returns>
+bool MatchServer::listen(const std::string& path) {
+	sockaddr_un address{};
+	if (m_listener >= 0 || path.empty() || path.size() >= sizeof(address.sun_path))
+		return false;
+	address.sun_family = AF_UNIX;
+	std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+	const int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listener < 0)
+		return false;
+	::unlink(path.c_str());
+	if (::bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || ::listen(listener, SOMAXCONN) != 0) {
+		::close(listener);
+		return false;
+	}
+	m_listener = listener;
+	m_path = path;
+	return true;
+}
+
+/// <summary>
+/// accepts connections until stop is called, then stops reading from the clients, waits until the requests
+/// already read are answered and removes the socket file
+/// </summary>
+void MatchServer::serve() {
+	while (m_listener >= 0 && !m_stopping) {
+		const int socket = ::accept(m_listener, nullptr, nullptr);
+		if (socket < 0) {
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			break; // stop shut the listener down
+		}
+#ifdef SO_NOSIGPIPE
+		const int enable = 1;
+		::setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, &enable, sizeof(enable));
+#endif
+		removeFinishedConnections();
+		auto connection = std::make_shared<Connection>();
+		connection->socket = socket;
+		std::lock_guard<std::mutex> lock(m_connectionsMutex);
+		m_connections.push_back(connection);
+		connection->reader = std::thread(&MatchServer::readRequests, this, connection);
+	}
+
+	std::list<std::shared_ptr<Connection>> connections;
+	{
+		std::lock_guard<std::mutex> lock(m_connectionsMutex);
+		for (const auto& connection : m_connections)
+			if (connection->socket >= 0)
+				::shutdown(connection->socket, SHUT_RD); // the readers see the end of the stream, responses still go out
+		connections.swap(m_connections);
+	}
+	for (const auto& connection : connections)
+		connection->reader.join();
+	if (m_listener >= 0) {
+		::close(m_listener);
+		::unlink(m_path.c_str());
+		m_listener = -1;
+	}
+}
+
+/// <summary>
+/// makes serve return; only sets a flag and shuts the listener down, so it can be called from a signal handler
+/// </summary>
+void MatchServer::stop() {
+	m_stopping = true;
+	if (m_listener >= 0)
+		::shutdown(m_listener, SHUT_RDWR);
+}
+
+void MatchServer::removeFinishedConnections() {
+	std::lock_guard<std::mutex> lock(m_connectionsMutex);
+	for (auto it = m_connections.begin(); it != m_connections.end();)
+		if ((*it)->finished) {
+			(*it)->reader.join();
+			it = m_connections.erase(it);
+		}
+		else
+			++it;
+}
+
+/// <summary>
+/// reads the frames of one connection into the queue until the client closes it or sends a frame that is too large,
+/// then waits for the pending responses and closes the socket
+/// </summary>
+/// <param name="connection"></param>
+void MatchServer::readRequests(std::shared_ptr<Connection> connection) {
+	char header[MatchProtocol::kHeaderSize];
+	while (readAll(connection->socket, header, sizeof(header))) {
+		Job job{ connection, MatchProtocol::decodeHeader(header), std::string() };
+		if (job.header.length > MatchProtocol::kMaxPayload)
+			break;
+		job.payload.resize(job.header.length);
+		if (!readAll(connection->socket, job.payload.data(), job.payload.size()))
+			break;
+		{
+			std::unique_lock<std::mutex> lock(connection->mutex);
+			connection->answered.wait(lock, [&] { return connection->inFlight < MatchProtocol::kMaxInFlight; });
+			connection->inFlight++;
+		}
+		{
+			std::lock_guard<std::mutex> lock(m_queueMutex);
+			m_queue.push_back(std::move(job));
+		}
+		m_queued.notify_one();
+	}
+	{
+		std::unique_lock<std::mutex> lock(connection->mutex);
+		connection->answered.wait(lock, [&] { return connection->inFlight == 0; });
+	}
+	std::lock_guard<std::mutex> lock(m_connectionsMutex); // serve must not shut down a socket number that was reused
+	::close(connection->socket);
+	connection->socket = -1;
+	connection->finished = true;
+}
+
+void MatchServer::work() {
+	while (true) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(m_queueMutex);
+			m_queued.wait(lock, [&] { return m_closingQueue || !m_queue.empty(); });
+			if (m_queue.empty())
+				return;
+			job = std::move(m_queue.front());
+			m_queue.pop_front();
+		}
+		MatchProtocol::Status status = MatchProtocol::Status::Ok;
+		const std::string payload = answer(job.header, job.payload, status);
+		MatchProtocol::FrameHeader response = job.header;
+		response.status = static_cast<std::uint8_t>(status);
+		const std::string bytes = MatchProtocol::frame(response, payload);
+		Connection& connection = *job.connection;
+		{
+			std::lock_guard<std::mutex> lock(connection.writeMutex);
+			writeAll(connection.socket, bytes.data(), bytes.size()); // if the client is gone its reader stops too
+		}
+		{
+			std::lock_guard<std::mutex> lock(connection.mutex);
+			connection.inFlight--;
+		}
+		connection.answered.notify_all();
+	}
+}
+
+/// <summary>
+/// payload of the response to one request; status is set when the request cannot be answered, and the payload is
+/// then empty
+/// </summary>
+/// <param name="request"></param>
+/// <param name="payload"></param>
+/// <param name="status"></param>
+/// <returns></returns>
+std::string MatchServer::answer(const MatchProtocol::FrameHeader& request, const std::string& payload, MatchProtocol::Status& status) const {
+	using MatchProtocol::Op;
+	using MatchProtocol::Status;
+	std::string result;
+	const Op op = static_cast<Op>(request.op);
+	if (op == Op::PatternCount) {
+		MatchProtocol::appendUint32(result, static_cast<std::uint32_t>(m_patterns.size()));
+		return result;
+	}
+	if (op != Op::Match && op != Op::Search && op != Op::SearchAll) {
+		status = Status::UnknownOp;
+		return {};
+	}
+	if (request.pattern >= m_patterns.size()) {
+		status = Status::UnknownPattern;
+		return {};
+	}
+	const Pattern& pattern = m_patterns[request.pattern];
+	if (op == Op::Match) {
+		for (std::size_t position = 0; position < payload.size();) {
+			if (payload.size() - position < 4) {
+				status = Status::BadPayload;
+				return {};
+			}
+			const std::uint32_t length = MatchProtocol::getUint32(payload.data() + position);
+			position += 4;
+			if (length > payload.size() - position) {
+				status = Status::BadPayload;
+				return {};
+			}
+			result += pattern.dfa.matches(std::string_view(payload).substr(position, length)) ? '\1' : '\0';
+			position += length;
+		}
+		return result;
+	}
+	pattern.searcher.search(payload, op == Op::SearchAll ? SearchMode::AllMatches : SearchMode::LeftmostLongest, [&](const Match& match) {
+		MatchProtocol::appendUint64(result, match.start);
+		MatchProtocol::appendUint64(result, match.end);
+	});
+	return result;
+}
+#endif
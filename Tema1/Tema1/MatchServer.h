@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "CompiledDFA.h"
+#include "MatchProtocol.h"
+#include "Searcher.h"
+
+/// <summary>
+/// long running matcher on a Unix domain socket (POSIX only). The patterns are compiled once when the server is
+/// created; every connection gets a reader thread that decodes frames (see MatchProtocol.h) into a queue shared by a
+/// fixed set of workers, and each worker writes its response as soon as it is done, so the requests of one
+/// connection are answered in parallel and out of order. A connection with kMaxInFlight requests pending is not read
+/// until some of them are answered.
+/// </summary>
+class MatchServer
+{
+protected:
+	struct Pattern
+	{
+		CompiledDFA dfa;
+		Searcher searcher;
+	};
+
+	struct Connection
+	{
+		int socket = -1;
+		std::mutex writeMutex; // responses of different workers must not interleave
+		std::mutex mutex;
+		std::condition_variable answered;
+		std::size_t inFlight = 0;
+		std::atomic<bool> finished{ false }; // the reader is done and every response was written
+		std::thread reader;
+	};
+
+	struct Job
+	{
+		std::shared_ptr<Connection> connection;
+		MatchProtocol::FrameHeader header;
+		std::string payload;
+	};
+
+	std::vector<Pattern> m_patterns;
+	std::string m_path;
+	int m_listener = -1;
+	std::atomic<bool> m_stopping{ false };
+
+	std::vector<std::thread> m_workers;
+	std::mutex m_queueMutex;
+	std::condition_variable m_queued;
+	std::deque<Job> m_queue;
+	bool m_closingQueue = false;
+
+	std::mutex m_connectionsMutex;
+	std::list<std::shared_ptr<Connection>> m_connections;
+
+	void work();
+	void readRequests(std::shared_ptr<Connection> connection);
+	std::string answer(const MatchProtocol::FrameHeader& request, const std::string& payload, MatchProtocol::Status& status) const;
+	void removeFinishedConnections();
+
+public:
+	explicit MatchServer(const std::vector<std::string>& expressions, std::size_t workerCount = std::thread::hardware_concurrency());
+	MatchServer(const MatchServer&) = delete;
+	MatchServer& operator=(const MatchServer&) = delete;
+	~MatchServer();
+
+	bool listen(const std::string& path);
+	void serve();
+	void stop();
+
+	std::size_t patternCount() const { return m_patterns.size(); }
+	std::size_t workerCount() const { return m_workers.size(); }
+};
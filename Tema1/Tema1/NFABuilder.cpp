@@ -0,0 +1,217 @@
+#include "NFABuilder.h"
+#include "PerformanceStats.h"
+#include <iostream>
+
+/// <summary>
+/// reserves room for the expected number of states, so that building usually takes a single allocation
+/// </summary>
+/// <param name="expectedStates"></param>
+NFABuilder::NFABuilder(std::size_t expectedStates) {
+	m_nodes.reserve(expectedStates);
+	m_classOfSymbol.fill(kNone);
+}
+
+NFABuilder::StateId NFABuilder::addState() {
+	m_nodes.emplace_back();
+	return static_cast<StateId>(m_nodes.size() - 1);
+}
+
+void NFABuilder::addLambdaEdge(StateId from, StateId to) {
+	Node& node = m_nodes[from];
+	node.out[node.out[0] == kNone ? 0 : 1] = to;
+}
+
+/// <summary>
+/// two states joined by an edge on the symbols of a class
+/// </summary>
+/// <param name="charClass"></param>
+/// <returns></returns>
+NFABuilder::Fragment NFABuilder::symbolEdge(std::uint32_t charClass) {
+	const StateId start = addState();
+	const StateId accept = addState();
+	m_nodes[start].charClass = charClass;
+	m_nodes[start].out[0] = accept;
+	return { start, accept };
+}
+
+/// <summary>
+/// two states joined by the symbol
+/// </summary>
+/// <param name="c"></param>
+/// <returns></returns>
+NFABuilder::Fragment NFABuilder::symbol(char c) {
+	std::uint32_t& charClass = m_classOfSymbol[static_cast<unsigned char>(c)];
+	if (charClass == kNone) { // every occurrence of a symbol shares its class
+		charClass = static_cast<std::uint32_t>(m_classes.size());
+		m_classes.emplace_back(c);
+	}
+	return symbolEdge(charClass);
+}
+
+/// <summary>
+/// two states joined by one edge that any byte of the class can take
+/// </summary>
+/// <param name="charClass"></param>
+/// <returns></returns>
+NFABuilder::Fragment NFABuilder::symbols(const CharClass& charClass) {
+	m_classes.push_back(charClass);
+	return symbolEdge(static_cast<std::uint32_t>(m_classes.size() - 1));
+}
+
+/// <summary>
+/// a's accept state gets a lambda edge to b's start state
+/// </summary>
+/// <param name="a"></param>
+/// <param name="b"></param>
+/// <returns></returns>
+NFABuilder::Fragment NFABuilder::concatenate(Fragment a, Fragment b) {
+	addLambdaEdge(a.accept, b.start);
+	return { a.start, b.accept };
+}
+
+/// <summary>
+/// a new start state with lambda edges to both fragments, whose accept states lead to a new accept state
+/// </summary>
+/// <param name="a"></param>
+/// <param name="b"></param>
+/// <returns></returns>
+NFABuilder::Fragment NFABuilder::alternate(Fragment a, Fragment b) {
+	const StateId start = addState();
+	const StateId accept = addState();
+	addLambdaEdge(start, a.start);
+	addLambdaEdge(start, b.start);
+	addLambdaEdge(a.accept, accept);
+	addLambdaEdge(b.accept, accept);
+	return { start, accept };
+}
+
+/// <summary>
+/// zero or more repetitions: the new start state may skip the fragment, and its accept state may loop back
+/// </summary>
+/// <param name="a"></param>
+/// <returns></returns>
+NFABuilder::Fragment NFABuilder::kleeneStar(Fragment a) {
+	const StateId start = addState();
+	const StateId accept = addState();
+	addLambdaEdge(start, a.start);
+	addLambdaEdge(start, accept);
+	addLambdaEdge(a.accept, a.start);
+	addLambdaEdge(a.accept, accept);
+	return { start, accept };
+}
+
+/// <summary>
+/// one or more repetitions: like kleeneStar without the edge that skips the fragment
+/// </summary>
+/// <param name="a"></param>
+/// <returns></returns>
+NFABuilder::Fragment NFABuilder::quantify(Fragment a) {
+	const StateId start = addState();
+	const StateId accept = addState();
+	addLambdaEdge(start, a.start);
+	addLambdaEdge(a.accept, a.start);
+	addLambdaEdge(a.accept, accept);
+	return { start, accept };
+}
+
+/// <summary>
+/// zero or one repetition: like kleeneStar without the edge that goes back into the fragment
+/// </summary>
+/// <param name="a"></param>
+/// <returns></returns>
+NFABuilder::Fragment NFABuilder::optional(Fragment a) {
+	const StateId start = addState();
+	const StateId accept = addState();
+	addLambdaEdge(start, a.start);
+	addLambdaEdge(start, accept);
+	addLambdaEdge(a.accept, accept);
+	return { start, accept };
+}
+
+/// <summary>
+/// copies the states into an IndexedNFA whose initial state is the fragment's start and whose only final state is
+/// its accept state, with the lambda closures precomputed. The classes are split into the ranges of
+/// CharClass::partition, so a class edge becomes one edge per range it covers
+/// </summary>
+/// <param name="fragment"></param>
+/// <returns></returns>
+IndexedNFA NFABuilder::build(Fragment fragment) const {
+	std::string alphabet, rangeEnds;
+	std::vector<std::string> symbolsOf;
+	if (!CharClass::partition(m_classes, alphabet, rangeEnds, symbolsOf)) {
+		std::cout << "Invalid Automaton";
+		return IndexedNFA("", 1, 0);
+	}
+	IndexedNFA nfa(alphabet, m_nodes.size(), fragment.start);
+	for (std::size_t i = 0; i < alphabet.size(); i++)
+		nfa.setRangeEnd(alphabet[i], rangeEnds[i]);
+	for (StateId state = 0; state < m_nodes.size(); state++) {
+		const Node& node = m_nodes[state];
+		if (node.charClass != kNone)
+			for (const char symbol : symbolsOf[node.charClass])
+				nfa.addEdge(state, symbol, node.out[0]);
+		else
+			for (const StateId target : node.out)
+				if (target != kNone)
+					nfa.addLambdaEdge(state, target);
+	}
+	nfa.setFinal(fragment.accept);
+	nfa.computeClosures();
+	return nfa;
+}
+
+/// <summary>
+/// builds the nfa of an expression in polish form (as returned by infixToPostfix) in one pass over it. Like createNFA
+/// the last fragment left on the stack is the result; an operator without enough operands, a malformed class or an
+/// empty expression prints "Invalid Automaton" and gives an nfa that accepts nothing
+/// </summary>
+/// <param name="polishForm"></param>
+/// <returns></returns>
+IndexedNFA NFABuilder::fromPostfix(const std::string& polishForm) {
+	STATS_PHASE(Thompson);
+	NFABuilder builder(2 * polishForm.size()); // every symbol and operator adds at most two states
+	std::vector<Fragment> stack;
+	stack.reserve(polishForm.size());
+	for (std::size_t i = 0; i < polishForm.size(); i++) {
+		const char symbol = polishForm[i];
+		const std::size_t operands = symbol == '.' || symbol == '|' ? 2 : symbol == '*' || symbol == '+' || symbol == '?' ? 1 : 0;
+		if (stack.size() < operands) {
+			stack.clear();
+			break;
+		}
+		if (operands == 0 && symbol == '[') {
+			const std::size_t end = CharClass::operandEnd(polishForm, i);
+			CharClass charClass;
+			if (!CharClass::parse(polishForm, i, end, charClass)) {
+				stack.clear();
+				break;
+			}
+			stack.push_back(builder.symbols(charClass));
+			i = end - 1;
+			continue;
+		}
+		if (operands == 0) {
+			stack.push_back(builder.symbol(symbol));
+			continue;
+		}
+		const Fragment b = stack.back();
+		if (operands == 2)
+			stack.pop_back();
+		Fragment& a = stack.back();
+		if (symbol == '.')
+			a = builder.concatenate(a, b);
+		else if (symbol == '|')
+			a = builder.alternate(a, b);
+		else if (symbol == '*')
+			a = builder.kleeneStar(a);
+		else if (symbol == '+')
+			a = builder.quantify(a);
+		else
+			a = builder.optional(a);
+	}
+	if (stack.empty()) {
+		std::cout << "Invalid Automaton";
+		return IndexedNFA("", 1, 0);
+	}
+	return builder.build(stack.back());
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <array>
+#include <string>
+#include <vector>
+#include "CharClass.h"
+#include "IndexedNFA.h"
+
+/// <summary>
+/// thompson construction in linear time: states live in one growing array, sub-automatons are referred to by their
+/// (start, accept) state ids and every combinator only adds a constant number of states and patches the accept
+/// states in place. Accept states never have outgoing edges until a combinator patches them, so no edge is ever copied
+/// </summary>
+class NFABuilder
+{
+public:
+	using StateId = IndexedNFA::StateId;
+	struct Fragment {
+		StateId start;
+		StateId accept;
+	};
+
+protected:
+	static constexpr StateId kNone = UINT32_MAX;
+	struct Node {
+		std::uint32_t charClass = kNone; // index in m_classes of the symbols of the edge, kNone for lambda edges
+		std::array<StateId, 2> out = { kNone, kNone }; // a thompson state has at most two outgoing edges
+	};
+
+	std::vector<Node> m_nodes;
+	std::vector<CharClass> m_classes;
+	std::array<std::uint32_t, 256> m_classOfSymbol; // index in m_classes of every single symbol already used
+
+	StateId addState();
+	void addLambdaEdge(StateId from, StateId to);
+	Fragment symbolEdge(std::uint32_t charClass);
+
+public:
+	explicit NFABuilder(std::size_t expectedStates = 0);
+
+	Fragment symbol(char c);
+	Fragment symbols(const CharClass& charClass);
+	Fragment concatenate(Fragment a, Fragment b);
+	Fragment alternate(Fragment a, Fragment b);
+	Fragment kleeneStar(Fragment a);
+	Fragment quantify(Fragment a);
+	Fragment optional(Fragment a);
+
+	IndexedNFA build(Fragment fragment) const;
+	static IndexedNFA fromPostfix(const std::string& polishForm);
+
+	std::size_t stateCount() const { return m_nodes.size(); }
+};
@@ -0,0 +1,129 @@
+#include "ParallelMatcher.h"
+#include "PerformanceStats.h"
+#include <algorithm>
+#include <numeric>
+
+/// <summary>
+/// offsets of the chunks the text is cut in (chunk i is [bounds[i], bounds[i + 1])), a few per thread
+/// </summary>
+/// <param name="size"></param>
+/// <param name="pool"></param>
+/// <returns></returns>
+std::vector<std::size_t> ParallelMatcher::chunkBounds(std::size_t size, const ThreadPool& pool) {
+	const std::size_t chunkCount = std::max<std::size_t>(1, std::min(pool.threadCount() * 4, size / kMinChunkSize));
+	std::vector<std::size_t> bounds(chunkCount + 1);
+	for (std::size_t i = 0; i <= chunkCount; i++)
+		bounds[i] = size / chunkCount * i;
+	bounds[chunkCount] = size;
+	return bounds;
+}
+
+CompiledDFA::State ParallelMatcher::walk(const CompiledDFA& dfa, CompiledDFA::State state, std::string_view chunk) {
+	return dfa.walk(state, chunk);
+}
+
+/// <summary>
+/// walks the chunk from every state of the dfa and stores in mapping the state each walk ends in. Every distinct
+/// current state is one lane; every kMergeInterval bytes the lanes in the same state are merged, and once a single
+/// lane is left the rest of the chunk is a plain walk
+/// </summary>
+/// <param name="dfa"></param>
+/// <param name="chunk"></param>
+/// <param name="mapping"></param>
+void ParallelMatcher::mapChunk(const CompiledDFA& dfa, std::string_view chunk, std::vector<CompiledDFA::State>& mapping) {
+	const std::size_t n = dfa.stateCount();
+	const std::uint32_t unassigned = UINT32_MAX;
+	std::vector<CompiledDFA::State> lanes(n); // current state of every lane
+	std::iota(lanes.begin(), lanes.end(), 0);
+	std::vector<std::uint32_t> laneOf(n); // start state -> its lane
+	std::iota(laneOf.begin(), laneOf.end(), 0);
+	std::vector<std::uint32_t> laneInState(n, unassigned); // used while merging
+	std::vector<std::uint32_t> newLane;
+	std::vector<CompiledDFA::State> merged;
+
+	std::size_t position = 0;
+	while (position < chunk.size() && lanes.size() > 1) {
+		const std::size_t end = std::min(chunk.size(), position + kMergeInterval);
+		for (; position < end; position++) {
+			const unsigned char byte = static_cast<unsigned char>(chunk[position]);
+			for (CompiledDFA::State& state : lanes) // the lanes do not depend on each other, so their loads overlap
+				state = dfa.next(state, byte);
+		}
+		merged.clear();
+		newLane.resize(lanes.size());
+		for (std::size_t lane = 0; lane < lanes.size(); lane++) {
+			if (laneInState[lanes[lane]] == unassigned) {
+				laneInState[lanes[lane]] = static_cast<std::uint32_t>(merged.size());
+				merged.push_back(lanes[lane]);
+			}
+			newLane[lane] = laneInState[lanes[lane]];
+		}
+		for (const CompiledDFA::State state : merged)
+			laneInState[state] = unassigned;
+		if (merged.size() < lanes.size()) {
+			for (std::uint32_t& lane : laneOf)
+				lane = newLane[lane];
+			lanes.swap(merged);
+		}
+	}
+	if (lanes.size() == 1)
+		lanes[0] = walk(dfa, lanes[0], chunk.substr(position));
+	mapping.resize(n);
+	for (std::size_t state = 0; state < n; state++)
+		mapping[state] = lanes[laneOf[state]];
+}
+
+/// <summary>
+/// the exact state of the dfa at every chunk boundary when the whole text is walked from the initial state:
+/// element i is the state at bounds[i], so the last one is the state after the text
+/// </summary>
+/// <param name="dfa"></param>
+/// <param name="text"></param>
+/// <param name="bounds">as returned by chunkBounds</param>
+/// <param name="pool"></param>
+/// <returns></returns>
+std::vector<CompiledDFA::State> ParallelMatcher::boundaryStates(const CompiledDFA& dfa, std::string_view text, const std::vector<std::size_t>& bounds, ThreadPool& pool) {
+	const std::size_t chunkCount = bounds.size() - 1;
+	std::vector<std::vector<CompiledDFA::State>> mappings(chunkCount);
+	CompiledDFA::State firstEnd = dfa.initialState();
+	pool.run(chunkCount, [&](std::size_t chunk) {
+		const std::string_view part = text.substr(bounds[chunk], bounds[chunk + 1] - bounds[chunk]);
+		if (chunk == 0)
+			firstEnd = walk(dfa, dfa.initialState(), part); // the only chunk whose start state is known
+		else
+			mapChunk(dfa, part, mappings[chunk]);
+	});
+	std::vector<CompiledDFA::State> states(chunkCount + 1);
+	states[0] = dfa.initialState();
+	if (chunkCount > 0)
+		states[1] = firstEnd;
+	for (std::size_t chunk = 1; chunk < chunkCount; chunk++)
+		states[chunk + 1] = mappings[chunk][states[chunk]];
+	return states;
+}
+
+/// <summary>
+/// the state the dfa ends in after the whole text, computed on all the threads of the pool
+/// </summary>
+/// <param name="dfa"></param>
+/// <param name="text"></param>
+/// <param name="pool"></param>
+/// <returns></returns>
+CompiledDFA::State ParallelMatcher::run(const CompiledDFA& dfa, std::string_view text, ThreadPool& pool) {
+	STATS_PHASE(Matching);
+	STATS_ADD(bytesScanned, text.size());
+	return boundaryStates(dfa, text, chunkBounds(text.size(), pool), pool).back();
+}
+
+/// <summary>
+/// same as dfa.matches(text), computed on all the threads of the pool
+/// </summary>
+/// <param name="dfa"></param>
+/// <param name="text"></param>
+/// <param name="pool"></param>
+/// <returns></returns>
+bool ParallelMatcher::matches(const CompiledDFA& dfa, std::string_view text, ThreadPool& pool) {
+	const bool accepted = dfa.isAccepting(run(dfa, text, pool));
+	STATS_ADD(matchesFound, accepted ? 1 : 0);
+	return accepted;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <string_view>
+#include <vector>
+#include "CompiledDFA.h"
+#include "ThreadPool.h"
+
+/// <summary>
+/// runs one dfa over one large text on several threads. The text is cut in chunks; the first chunk is walked from
+/// the initial state, every other chunk from all the states at once, which gives a state -> state mapping per chunk.
+/// A prefix pass over the mappings then gives the exact state at every chunk boundary. Walks from different states
+/// usually end up in the same state after a few bytes, so the lanes are merged as they meet and most of a chunk
+/// is walked with a single state; a minimized dfa keeps the initial number of lanes small.
+/// </summary>
+class ParallelMatcher
+{
+public:
+	static constexpr std::size_t kMinChunkSize = 64 * 1024; // smaller chunks are not worth a task
+	static constexpr std::size_t kMergeInterval = 16; // bytes between two merges of the lanes that met
+
+	static std::vector<std::size_t> chunkBounds(std::size_t size, const ThreadPool& pool);
+	static std::vector<CompiledDFA::State> boundaryStates(const CompiledDFA& dfa, std::string_view text, const std::vector<std::size_t>& bounds, ThreadPool& pool);
+	static CompiledDFA::State run(const CompiledDFA& dfa, std::string_view text, ThreadPool& pool);
+	static bool matches(const CompiledDFA& dfa, std::string_view text, ThreadPool& pool);
+
+protected:
+	static CompiledDFA::State walk(const CompiledDFA& dfa, CompiledDFA::State state, std::string_view chunk);
+	static void mapChunk(const CompiledDFA& dfa, std::string_view chunk, std::vector<CompiledDFA::State>& mapping);
+};
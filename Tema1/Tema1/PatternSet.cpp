@@ -0,0 +1,93 @@
+#include "PatternSet.h"
+#include "Automaton.h"
+#include "PerformanceStats.h"
+#include <map>
+
+/// <summary>
+/// builds the nfa of every pattern, joins them under a new start state with lambda edges to each of them, then
+/// determinizes and minimizes the result without merging states that accept different patterns
+/// </summary>
+/// <param name="patterns"></param>
+PatternSet::PatternSet(const std::vector<std::string>& patterns)
+	: m_patterns(patterns) {
+	std::vector<IndexedNFA> parts;
+	std::vector<CharClass> symbolRanges; // the bytes every symbol of every part stands for
+	std::size_t stateCount = 1; // the shared start state
+	for (const auto& pattern : m_patterns) {
+		parts.push_back(NFABuilder::fromPostfix(RegexTree::simplify(infixToPostfix(pattern))));
+		for (const char symbol : parts.back().alphabet()) {
+			symbolRanges.emplace_back();
+			symbolRanges.back().add(static_cast<unsigned char>(symbol), parts.back().rangeEnd(symbol));
+		}
+		stateCount += parts.back().stateCount();
+	}
+	// the parts split the bytes in different ranges, so their symbols are split again into ranges common to all
+	std::string alphabet, rangeEnds;
+	std::vector<std::string> symbolsOf;
+	if (!CharClass::partition(symbolRanges, alphabet, rangeEnds, symbolsOf)) {
+		std::cout << "Invalid Automaton";
+		m_tags.assign(1, {}); // the empty dfa: no word matches any pattern
+		m_tagOf.assign(m_dfa.stateCount(), 0);
+		return;
+	}
+
+	IndexedNFA combined(alphabet, stateCount, 0);
+	for (std::size_t i = 0; i < alphabet.size(); i++)
+		combined.setRangeEnd(alphabet[i], rangeEnds[i]);
+	std::size_t firstRange = 0; // index in symbolRanges of the first symbol of the current part
+	std::vector<StateSet> finalsOf; // final states of every pattern, numbered as in the combined nfa
+	IndexedNFA::StateId offset = 1;
+	for (const auto& part : parts) {
+		for (IndexedNFA::StateId state = 0; state < part.stateCount(); state++) {
+			for (const auto& edge : part.edges(state)) {
+				const std::size_t range = firstRange + part.alphabet().find(edge.symbol);
+				for (const char symbol : symbolsOf[range])
+					combined.addEdge(offset + state, symbol, offset + edge.target);
+			}
+			for (const auto target : part.lambdaEdges(state))
+				combined.addLambdaEdge(offset + state, offset + target);
+		}
+		combined.addLambdaEdge(0, offset + part.initialState());
+		finalsOf.emplace_back(stateCount);
+		part.finalStates().forEach([&](std::size_t state) {
+			combined.setFinal(static_cast<IndexedNFA::StateId>(offset + state));
+			finalsOf.back().insert(offset + state);
+		});
+		offset += static_cast<IndexedNFA::StateId>(part.stateCount());
+		firstRange += part.alphabet().size();
+	}
+	combined.computeClosures();
+
+	std::map<std::vector<std::uint32_t>, std::uint32_t> tagIds = { { {}, 0 } };
+	std::vector<std::uint32_t> labels(1, 0); // label of the dead state: no pattern
+	CompiledDFA dfa = CompiledDFA::fromNFA(combined, false, [&](CompiledDFA::State state, const StateSet& set) {
+		std::vector<std::uint32_t> accepted;
+		for (std::uint32_t id = 0; id < finalsOf.size(); id++)
+			if (set.intersects(finalsOf[id]))
+				accepted.push_back(id);
+		labels.resize(state + 1, 0);
+		labels[state] = tagIds.emplace(std::move(accepted), static_cast<std::uint32_t>(tagIds.size())).first->second;
+	});
+
+	std::vector<CompiledDFA::State> newStateOf;
+	m_dfa = dfa.minimize(labels, &newStateOf);
+	m_tags.resize(tagIds.size());
+	for (auto& [accepted, id] : tagIds)
+		m_tags[id] = accepted;
+	m_tagOf.assign(m_dfa.stateCount(), 0);
+	for (std::size_t state = 0; state < labels.size(); state++)
+		m_tagOf[newStateOf[state]] = labels[state];
+}
+
+/// <summary>
+/// ids of the patterns that accept the whole word, in increasing order; no allocation
+/// </summary>
+/// <param name="word"></param>
+/// <returns></returns>
+const std::vector<std::uint32_t>& PatternSet::matches(std::string_view word) const {
+	STATS_PHASE(Matching);
+	const CompiledDFA::State state = m_dfa.walk(m_dfa.initialState(), word);
+	STATS_ADD(bytesScanned, word.size());
+	STATS_ADD(matchesFound, m_tags[m_tagOf[state]].size());
+	return m_tags[m_tagOf[state]];
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "CompiledDFA.h"
+
+/// <summary>
+/// several expressions compiled into one dfa: their nfas hang off a shared start state and every dfa state is
+/// tagged with the ids (positions in the constructor's list) of the patterns it accepts, so one pass over a word
+/// tells which of the patterns match it, whatever their number
+/// </summary>
+class PatternSet
+{
+protected:
+	std::vector<std::string> m_patterns;
+	CompiledDFA m_dfa;
+	std::vector<std::uint32_t> m_tagOf; // dfa state -> index in m_tags
+	std::vector<std::vector<std::uint32_t>> m_tags; // distinct sorted lists of pattern ids, m_tags[0] is the empty list
+
+public:
+	explicit PatternSet(const std::vector<std::string>& patterns);
+
+	const std::vector<std::uint32_t>& matches(std::string_view word) const;
+
+	std::size_t size() const { return m_patterns.size(); }
+	const std::string& pattern(std::uint32_t id) const { return m_patterns[id]; }
+	const CompiledDFA& dfa() const { return m_dfa; }
+};
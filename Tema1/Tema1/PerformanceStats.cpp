@@ -0,0 +1,117 @@
+#include "PerformanceStats.h"
+#include <cstdlib>
+#include <new>
+#include <sstream>
+
+namespace {
+	thread_local PerformanceStats* t_current = nullptr;
+	thread_local std::uint64_t t_allocatedBytes = 0;
+}
+
+#ifdef TEMA1_STATS
+// the global allocation functions are replaced to count the bytes of every phase; this only exists in stats builds
+void* operator new(std::size_t size) {
+	t_allocatedBytes += size;
+	if (void* memory = std::malloc(size == 0 ? 1 : size))
+		return memory;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+	std::free(memory);
+}
+#endif
+
+const char* PerformanceStats::phaseName(Phase phase) {
+	switch (phase) {
+	case Phase::Postfix: return "postfix";
+	case Phase::Simplification: return "simplification";
+	case Phase::Thompson: return "thompson";
+	case Phase::Glushkov: return "glushkov";
+	case Phase::Indexing: return "indexing";
+	case Phase::SubsetConstruction: return "subsetConstruction";
+	case Phase::Minimization: return "minimization";
+	case Phase::Matching: return "matching";
+	default: return "unknown";
+	}
+}
+
+/// <summary>
+/// the stats object of the innermost scope of the calling thread, or nullptr if there is none
+/// </summary>
+/// <returns></returns>
+PerformanceStats* PerformanceStats::current() {
+	return t_current;
+}
+
+/// <summary>
+/// adds the counters and the allocated bytes of another object, for work that other threads did on behalf of this
+/// one. The seconds are left out: the phase timer of the calling thread already spans that work
+/// </summary>
+/// <param name="other"></param>
+void PerformanceStats::addCounters(const PerformanceStats& other) {
+	for (std::size_t i = 0; i < bytesAllocated.size(); i++)
+		bytesAllocated[i] += other.bytesAllocated[i];
+	termsBeforeSimplification += other.termsBeforeSimplification;
+	termsAfterSimplification += other.termsAfterSimplification;
+	nfaStates += other.nfaStates;
+	nfaTransitions += other.nfaTransitions;
+	dfaStates += other.dfaStates;
+	dfaTransitions += other.dfaTransitions;
+	minimizedStates += other.minimizedStates;
+	closureCalls += other.closureCalls;
+	hashCollisions += other.hashCollisions;
+	bytesScanned += other.bytesScanned;
+	matchesFound += other.matchesFound;
+}
+
+std::string PerformanceStats::toJson() const {
+	std::ostringstream out;
+	out << "{\n  \"enabled\": " << (kEnabled ? "true" : "false") << ",\n  \"phases\": {\n";
+	for (std::size_t i = 0; i < seconds.size(); i++) {
+		out << "    \"" << phaseName(static_cast<Phase>(i)) << "\": { \"seconds\": " << seconds[i]
+			<< ", \"bytesAllocated\": " << bytesAllocated[i] << " }" << (i + 1 < seconds.size() ? ",\n" : "\n");
+	}
+	out << "  },\n"
+		<< "  \"termsBeforeSimplification\": " << termsBeforeSimplification << ",\n"
+		<< "  \"termsAfterSimplification\": " << termsAfterSimplification << ",\n"
+		<< "  \"nfaStates\": " << nfaStates << ",\n"
+		<< "  \"nfaTransitions\": " << nfaTransitions << ",\n"
+		<< "  \"dfaStates\": " << dfaStates << ",\n"
+		<< "  \"dfaTransitions\": " << dfaTransitions << ",\n"
+		<< "  \"minimizedStates\": " << minimizedStates << ",\n"
+		<< "  \"closureCalls\": " << closureCalls << ",\n"
+		<< "  \"hashCollisions\": " << hashCollisions << ",\n"
+		<< "  \"bytesScanned\": " << bytesScanned << ",\n"
+		<< "  \"matchesFound\": " << matchesFound << "\n}\n";
+	return out.str();
+}
+
+StatsScope::StatsScope(PerformanceStats& stats)
+	: m_previous(t_current) {
+	t_current = &stats;
+}
+
+StatsScope::~StatsScope() {
+	t_current = m_previous;
+}
+
+PhaseTimer::PhaseTimer(PerformanceStats::Phase phase)
+	: m_stats(t_current), m_phase(phase) {
+	if (m_stats == nullptr)
+		return;
+	m_allocatedAtStart = t_allocatedBytes;
+	m_start = std::chrono::steady_clock::now();
+}
+
+PhaseTimer::~PhaseTimer() {
+	if (m_stats == nullptr)
+		return;
+	const std::size_t phase = static_cast<std::size_t>(m_phase);
+	m_stats->seconds[phase] += std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+	m_stats->bytesAllocated[phase] += t_allocatedBytes - m_allocatedAtStart;
+}
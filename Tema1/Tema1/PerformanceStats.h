@@ -0,0 +1,93 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/// <summary>
+/// opt-in counters filled in by the compilation and matching code. They are collected only when the project is built
+/// with TEMA1_STATS defined; otherwise the STATS_ macros below expand to nothing and the object stays zero.
+/// Collection is per thread: the counters go to the object of the innermost StatsScope of the calling thread, and
+/// values like state counts are summed over every automaton built inside the scope. Work handed to a thread pool
+/// counts into a scope of every task, whose counters are added back to the caller's object with addCounters
+/// </summary>
+struct PerformanceStats
+{
+	enum class Phase {
+		Postfix,
+		Simplification,
+		Thompson,
+		Glushkov,
+		Indexing,
+		SubsetConstruction,
+		Minimization,
+		Matching,
+		Count
+	};
+
+#ifdef TEMA1_STATS
+	static constexpr bool kEnabled = true;
+#else
+	static constexpr bool kEnabled = false;
+#endif
+
+	std::array<double, static_cast<std::size_t>(Phase::Count)> seconds{}; // wall time of every phase
+	std::array<std::uint64_t, static_cast<std::size_t>(Phase::Count)> bytesAllocated{}; // operator new bytes of every phase
+	std::uint64_t termsBeforeSimplification = 0; // operands and operators of the polish form
+	std::uint64_t termsAfterSimplification = 0;
+	std::uint64_t nfaStates = 0;
+	std::uint64_t nfaTransitions = 0; // symbol and lambda edges
+	std::uint64_t dfaStates = 0; // without the dead state
+	std::uint64_t dfaTransitions = 0; // table entries that do not lead to the dead state
+	std::uint64_t minimizedStates = 0;
+	std::uint64_t closureCalls = 0;
+	std::uint64_t hashCollisions = 0; // state set table probes that hit a bucket of another set
+	std::uint64_t bytesScanned = 0;
+	std::uint64_t matchesFound = 0;
+
+	static const char* phaseName(Phase phase);
+	static PerformanceStats* current();
+	void addCounters(const PerformanceStats& other);
+	std::string toJson() const;
+};
+
+/// <summary>
+/// makes the stats object the target of the calling thread's counters until the scope ends
+/// </summary>
+class StatsScope
+{
+protected:
+	PerformanceStats* m_previous;
+
+public:
+	explicit StatsScope(PerformanceStats& stats);
+	StatsScope(const StatsScope&) = delete;
+	StatsScope& operator=(const StatsScope&) = delete;
+	~StatsScope();
+};
+
+/// <summary>
+/// adds the wall time and the allocated bytes between construction and destruction to a phase of the current stats
+/// </summary>
+class PhaseTimer
+{
+protected:
+	PerformanceStats* m_stats;
+	PerformanceStats::Phase m_phase;
+	std::chrono::steady_clock::time_point m_start;
+	std::uint64_t m_allocatedAtStart = 0;
+
+public:
+	explicit PhaseTimer(PerformanceStats::Phase phase);
+	PhaseTimer(const PhaseTimer&) = delete;
+	PhaseTimer& operator=(const PhaseTimer&) = delete;
+	~PhaseTimer();
+};
+
+#ifdef TEMA1_STATS
+#define STATS_ADD(field, amount) do { if (PerformanceStats* stats_ = PerformanceStats::current()) stats_->field += (amount); } while (0)
+#define STATS_PHASE(phase) PhaseTimer phaseTimer_(PerformanceStats::Phase::phase)
+#else
+#define STATS_ADD(field, amount) ((void)0)
+#define STATS_PHASE(phase) ((void)0)
+#endif
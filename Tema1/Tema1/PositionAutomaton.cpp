@@ -0,0 +1,124 @@
+#include "PositionAutomaton.h"
+#include "CharClass.h"
+#include "PerformanceStats.h"
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <vector>
+
+namespace {
+	/// <summary>
+	/// a node of the syntax tree, reduced to what its parent needs; positions of different subtrees are distinct,
+	/// so the union of two lists is their concatenation
+	/// </summary>
+	struct Node
+	{
+		bool nullable = false;
+		std::vector<std::uint32_t> first;
+		std::vector<std::uint32_t> last;
+	};
+
+	void append(std::vector<std::uint32_t>& to, const std::vector<std::uint32_t>& from) {
+		to.insert(to.end(), from.begin(), from.end());
+	}
+}
+
+/// <summary>
+/// builds the position automaton of an expression in polish form (as returned by infixToPostfix). State 0 is the
+/// initial state and state p is position p; there is an edge p -> q on the symbol of q for every q in followpos(p),
+/// with followpos(0) = firstpos of the whole expression; a class gives one edge per range of CharClass::partition.
+/// The final states are lastpos, plus 0 if the expression is nullable. Like NFABuilder::fromPostfix an invalid
+/// expression prints "Invalid Automaton" and accepts nothing
+/// </summary>
+/// <param name="polishForm"></param>
+/// <returns></returns>
+IndexedNFA PositionAutomaton::fromPostfix(const std::string& polishForm) {
+	STATS_PHASE(Glushkov);
+	std::vector<CharClass> classes; // distinct classes of the positions
+	std::vector<std::uint32_t> classOf(1, 0); // class of every position, position 0 has none
+	std::array<std::uint32_t, 256> classOfSymbol; // index in classes of every single symbol already used
+	classOfSymbol.fill(UINT32_MAX);
+	std::vector<std::vector<std::uint32_t>> follow(1);
+	std::vector<Node> stack;
+	bool valid = true;
+	for (std::size_t i = 0; i < polishForm.size() && valid; i++) {
+		const char symbol = polishForm[i];
+		const std::size_t operands = symbol == '.' || symbol == '|' ? 2 : symbol == '*' || symbol == '+' || symbol == '?' ? 1 : 0;
+		if (stack.size() < operands) {
+			valid = false;
+			break;
+		}
+		if (operands == 0) {
+			const std::uint32_t position = static_cast<std::uint32_t>(classOf.size());
+			if (symbol == '[') {
+				const std::size_t end = CharClass::operandEnd(polishForm, i);
+				classes.emplace_back();
+				valid = CharClass::parse(polishForm, i, end, classes.back());
+				classOf.push_back(static_cast<std::uint32_t>(classes.size() - 1));
+				i = end - 1;
+			}
+			else {
+				std::uint32_t& charClass = classOfSymbol[static_cast<unsigned char>(symbol)];
+				if (charClass == UINT32_MAX) {
+					charClass = static_cast<std::uint32_t>(classes.size());
+					classes.emplace_back(symbol);
+				}
+				classOf.push_back(charClass);
+			}
+			follow.emplace_back();
+			stack.push_back({ false, { position }, { position } });
+			continue;
+		}
+		if (operands == 1) { // * and + : the last positions can go back to the first ones; ? only makes it nullable
+			Node& a = stack.back();
+			if (symbol != '?')
+				for (const std::uint32_t position : a.last)
+					append(follow[position], a.first);
+			if (symbol != '+')
+				a.nullable = true;
+			continue;
+		}
+		Node b = std::move(stack.back());
+		stack.pop_back();
+		Node& a = stack.back();
+		if (symbol == '|') {
+			a.nullable = a.nullable || b.nullable;
+			append(a.first, b.first);
+			append(a.last, b.last);
+			continue;
+		}
+		for (const std::uint32_t position : a.last) // concatenation: the last positions of a lead to the first of b
+			append(follow[position], b.first);
+		if (a.nullable)
+			append(a.first, b.first);
+		if (b.nullable)
+			append(b.last, a.last);
+		a.last = std::move(b.last);
+		a.nullable = a.nullable && b.nullable;
+	}
+	std::string alphabet, rangeEnds;
+	std::vector<std::string> symbolsOf;
+	if (!valid || stack.empty() || !CharClass::partition(classes, alphabet, rangeEnds, symbolsOf)) {
+		std::cout << "Invalid Automaton";
+		return IndexedNFA("", 1, 0);
+	}
+
+	const Node& root = stack.back();
+	follow[0] = root.first;
+	IndexedNFA nfa(alphabet, classOf.size(), 0);
+	for (std::size_t i = 0; i < alphabet.size(); i++)
+		nfa.setRangeEnd(alphabet[i], rangeEnds[i]);
+	for (std::uint32_t position = 0; position < follow.size(); position++) {
+		std::vector<std::uint32_t>& targets = follow[position];
+		std::sort(targets.begin(), targets.end()); // nested stars add the same positions more than once
+		targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+		for (const std::uint32_t target : targets)
+			for (const char symbol : symbolsOf[classOf[target]]) // one edge per range of the target's class
+				nfa.addEdge(position, symbol, target);
+	}
+	for (const std::uint32_t position : root.last)
+		nfa.setFinal(position);
+	if (root.nullable)
+		nfa.setFinal(0);
+	return nfa;
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <string>
+#include "IndexedNFA.h"
+
+/// <summary>
+/// glushkov (position) construction: every symbol occurrence of the expression is a position, and nullable, firstpos,
+/// lastpos and followpos are computed bottom up over the syntax tree given by the polish form. The result is an nfa
+/// without lambda edges, whose states are the positions plus an initial state, so determinizing it is the classic
+/// followpos subset construction
+/// </summary>
+class PositionAutomaton
+{
+public:
+	static IndexedNFA fromPostfix(const std::string& polishForm);
+};
@@ -0,0 +1,235 @@
+#include "Prefilter.h"
+#include "CharClass.h"
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <stack>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PREFILTER_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+	/// <summary>
+	/// what is known about the strings matched by a sub-expression
+	/// </summary>
+	struct LiteralInfo
+	{
+		std::optional<std::string> exact; // the only string it matches, if there is just one
+		std::string prefix; // every match starts with it
+		std::string suffix; // every match ends with it
+		std::string required; // every match contains it
+		std::size_t requiredOffset = 0; // required starts at most this far into a match
+		std::size_t maxLength = 0; // longest match, or kUnbounded
+	};
+
+	std::size_t add(std::size_t a, std::size_t b) {
+		return (a == Prefilter::kUnbounded || b == Prefilter::kUnbounded) ? Prefilter::kUnbounded : a + b;
+	}
+
+	/// <summary>
+	/// keeps the better of two required literals: the longer one, or the one with a known offset on a tie
+	/// </summary>
+	void pickRequired(LiteralInfo& info, const std::string& literal, std::size_t offset) {
+		if (literal.size() > info.required.size() || (literal.size() == info.required.size() && offset < info.requiredOffset)) {
+			info.required = literal;
+			info.requiredOffset = offset;
+		}
+	}
+
+	LiteralInfo symbolInfo(char symbol) {
+		LiteralInfo info;
+		info.exact = std::string(1, symbol);
+		info.prefix = info.suffix = info.required = *info.exact;
+		info.maxLength = 1;
+		return info;
+	}
+
+	LiteralInfo concatenateInfo(const LiteralInfo& a, const LiteralInfo& b) {
+		LiteralInfo info;
+		if (a.exact && b.exact)
+			info.exact = *a.exact + *b.exact;
+		info.prefix = a.exact ? *a.exact + b.prefix : a.prefix;
+		info.suffix = b.exact ? a.suffix + *b.exact : b.suffix;
+		info.maxLength = add(a.maxLength, b.maxLength);
+		info.requiredOffset = Prefilter::kUnbounded;
+		pickRequired(info, info.prefix, 0);
+		pickRequired(info, a.required, a.requiredOffset);
+		pickRequired(info, b.required, add(a.maxLength, b.requiredOffset));
+		const std::string joined = a.suffix + b.prefix; // a's suffix runs straight into b's prefix
+		pickRequired(info, joined, a.maxLength == Prefilter::kUnbounded ? Prefilter::kUnbounded : a.maxLength - a.suffix.size());
+		return info;
+	}
+
+	LiteralInfo alternateInfo(const LiteralInfo& a, const LiteralInfo& b) {
+		LiteralInfo info;
+		if (a.exact && b.exact && *a.exact == *b.exact)
+			info.exact = a.exact;
+		const std::size_t prefixLength = std::mismatch(a.prefix.begin(), a.prefix.begin() + std::min(a.prefix.size(), b.prefix.size()), b.prefix.begin()).first - a.prefix.begin();
+		info.prefix = a.prefix.substr(0, prefixLength);
+		const std::size_t suffixLength = std::mismatch(a.suffix.rbegin(), a.suffix.rbegin() + std::min(a.suffix.size(), b.suffix.size()), b.suffix.rbegin()).first - a.suffix.rbegin();
+		info.suffix = a.suffix.substr(a.suffix.size() - suffixLength);
+		info.maxLength = std::max(a.maxLength, b.maxLength);
+		info.requiredOffset = Prefilter::kUnbounded;
+		pickRequired(info, info.prefix, 0);
+		pickRequired(info, info.suffix, info.maxLength == Prefilter::kUnbounded ? Prefilter::kUnbounded : info.maxLength - info.suffix.size());
+		if (a.required == b.required)
+			pickRequired(info, a.required, std::max(a.requiredOffset, b.requiredOffset));
+		return info;
+	}
+
+	LiteralInfo starInfo() {
+		LiteralInfo info; // can match the empty string, so nothing is required
+		info.maxLength = Prefilter::kUnbounded;
+		return info;
+	}
+
+	LiteralInfo optionalInfo(const LiteralInfo& a) {
+		LiteralInfo info; // can match the empty string, so nothing is required
+		info.maxLength = a.maxLength;
+		return info;
+	}
+
+	LiteralInfo plusInfo(const LiteralInfo& a) {
+		LiteralInfo info = a; // the first repetition still provides the prefix and the required literal
+		info.exact.reset();
+		info.maxLength = Prefilter::kUnbounded;
+		return info;
+	}
+
+	std::size_t countTrailingZeros(std::uint32_t mask) {
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return index;
+#else
+		return static_cast<std::size_t>(__builtin_ctz(mask));
+#endif
+	}
+}
+
+/// <summary>
+/// walks the postfix form like createNFA does, but instead of automata it keeps a LiteralInfo for every
+/// sub-expression; the result is the longest literal required by the whole expression
+/// </summary>
+/// <param name="polishForm"></param>
+/// <returns></returns>
+Prefilter Prefilter::fromPostfix(const std::string& polishForm) {
+	std::stack<LiteralInfo> st;
+	for (std::size_t i = 0; i < polishForm.size(); i++) {
+		const char symbol = polishForm[i];
+		if (symbol == '[') { // a class is one byte that is not known in advance
+			LiteralInfo info;
+			info.maxLength = 1;
+			st.push(info);
+			i = CharClass::operandEnd(polishForm, i) - 1;
+			continue;
+		}
+		if (symbol != '*' && symbol != '.' && symbol != '|' && symbol != '+' && symbol != '?') {
+			st.push(symbolInfo(symbol));
+			continue;
+		}
+		const std::size_t operands = (symbol == '*' || symbol == '+' || symbol == '?') ? 1 : 2;
+		if (st.size() < operands)
+			return {}; // malformed expression, no prefilter
+		LiteralInfo b = st.top(); st.pop();
+		if (symbol == '*')
+			st.push(starInfo());
+		else if (symbol == '?')
+			st.push(optionalInfo(b));
+		else if (symbol == '+')
+			st.push(plusInfo(b));
+		else {
+			LiteralInfo a = st.top(); st.pop();
+			st.push(symbol == '.' ? concatenateInfo(a, b) : alternateInfo(a, b));
+		}
+	}
+	if (st.size() != 1 || st.top().required.empty())
+		return {};
+	return Prefilter(st.top().required, st.top().requiredOffset);
+}
+
+/// <summary>
+/// position of the first occurrence of literal in text at or after from, or npos. Candidates are found by comparing
+/// the first and the last byte of the literal against 32 (AVX2) or 16 (SSE2) positions at once and then checked
+/// with memcmp; without SIMD, memchr looks for the first byte
+/// </summary>
+/// <param name="text"></param>
+/// <param name="from"></param>
+/// <param name="literal"></param>
+/// <returns></returns>
+std::size_t Prefilter::findLiteral(std::string_view text, std::size_t from, std::string_view literal) {
+	const std::size_t m = literal.size();
+	const std::size_t n = text.size();
+	if (m == 0)
+		return from <= n ? from : npos;
+	if (from >= n || n - from < m)
+		return npos;
+	const char* data = text.data();
+	std::size_t i = from;
+	if (m > 1) {
+#if defined(__AVX2__)
+		const __m256i first = _mm256_set1_epi8(literal[0]);
+		const __m256i last = _mm256_set1_epi8(literal[m - 1]);
+		for (; i + m - 1 + 32 <= n; i += 32) {
+			const __m256i blockFirst = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+			const __m256i blockLast = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + m - 1));
+			std::uint32_t mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(first, blockFirst), _mm256_cmpeq_epi8(last, blockLast))));
+			for (; mask != 0; mask &= mask - 1) {
+				const std::size_t candidate = i + countTrailingZeros(mask);
+				if (std::memcmp(data + candidate + 1, literal.data() + 1, m - 2) == 0)
+					return candidate;
+			}
+		}
+#elif defined(PREFILTER_SSE2)
+		const __m128i first = _mm_set1_epi8(literal[0]);
+		const __m128i last = _mm_set1_epi8(literal[m - 1]);
+		for (; i + m - 1 + 16 <= n; i += 16) {
+			const __m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+			const __m128i blockLast = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + m - 1));
+			std::uint32_t mask = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, blockFirst), _mm_cmpeq_epi8(last, blockLast))));
+			for (; mask != 0; mask &= mask - 1) {
+				const std::size_t candidate = i + countTrailingZeros(mask);
+				if (std::memcmp(data + candidate + 1, literal.data() + 1, m - 2) == 0)
+					return candidate;
+			}
+		}
+#endif
+	}
+	while (i + m <= n) { // scalar tail, or the whole text without simd
+		const void* found = std::memchr(data + i, literal[0], n - m + 1 - i);
+		if (found == nullptr)
+			return npos;
+		i = static_cast<const char*>(found) - data;
+		if (std::memcmp(data + i + 1, literal.data() + 1, m - 1) == 0)
+			return i;
+		i++;
+	}
+	return npos;
+}
+
+/// <summary>
+/// smallest position at or after from where a match ending at or before to can start, or npos if there is none;
+/// the literal is only looked for in text[from, to), so a chunk of a parallel search does not scan the rest of the
+/// text. occurrence caches the last occurrence of the literal found, so repeated calls do not scan the same bytes
+/// again (start it at npos)
+/// </summary>
+/// <param name="text"></param>
+/// <param name="from"></param>
+/// <param name="to"></param>
+/// <param name="occurrence"></param>
+/// <returns></returns>
+std::size_t Prefilter::nextCandidate(std::string_view text, std::size_t from, std::size_t to, std::size_t& occurrence) const {
+	if (occurrence == npos || occurrence < from)
+		occurrence = findLiteral(text.substr(0, to), from, m_literal);
+	if (occurrence == npos)
+		return npos;
+	if (m_maxOffset == kUnbounded || occurrence - from <= m_maxOffset)
+		return from;
+	return occurrence - m_maxOffset;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/// <summary>
+/// literal every match has to contain, extracted from the postfix form of an expression, together with how far
+/// from the start of a match it can begin; the search uses it to jump straight to the places where a match can start
+/// </summary>
+class Prefilter
+{
+public:
+	static constexpr std::size_t kUnbounded = SIZE_MAX;
+	static constexpr std::size_t npos = SIZE_MAX;
+
+protected:
+	std::string m_literal; // empty if nothing is required
+	std::size_t m_maxOffset = kUnbounded; // the literal starts at most this many bytes after the start of a match
+
+public:
+	Prefilter() = default;
+	Prefilter(std::string literal, std::size_t maxOffset) : m_literal(std::move(literal)), m_maxOffset(maxOffset) {}
+
+	static Prefilter fromPostfix(const std::string& polishForm);
+	static std::size_t findLiteral(std::string_view text, std::size_t from, std::string_view literal);
+
+	std::size_t nextCandidate(std::string_view text, std::size_t from, std::size_t to, std::size_t& occurrence) const;
+
+	bool empty() const { return m_literal.empty(); }
+	const std::string& literal() const { return m_literal; }
+	std::size_t maxOffset() const { return m_maxOffset; }
+	bool isPrefix() const { return !m_literal.empty() && m_maxOffset == 0; }
+};
@@ -0,0 +1,456 @@
+#include "RegexTree.h"
+#include "PerformanceStats.h"
+#include <algorithm>
+
+std::size_t RegexTree::KeyHash::operator()(const Key& key) const {
+	std::uint64_t hash = key.operands * 0x9E3779B97F4A7C15ull;
+	hash ^= (static_cast<std::uint64_t>(key.charClass) << 8 | static_cast<std::uint64_t>(key.kind)) + (hash >> 29);
+	return static_cast<std::size_t>(hash * 0xBF58476D1CE4E5B9ull);
+}
+
+/// <summary>
+/// id of the node with these fields, created if it does not exist yet
+/// </summary>
+/// <param name="kind"></param>
+/// <param name="left"></param>
+/// <param name="right"></param>
+/// <param name="charClass"></param>
+/// <returns></returns>
+RegexTree::NodeId RegexTree::intern(Kind kind, NodeId left, NodeId right, std::uint32_t charClass) {
+	const Key key{ static_cast<std::uint64_t>(left) << 32 | right, charClass, kind };
+	auto [it, inserted] = m_ids.emplace(key, static_cast<NodeId>(m_nodes.size()));
+	if (!inserted)
+		return it->second;
+	bool nullable = false;
+	if (kind == Kind::Concatenation)
+		nullable = m_nodes[left].nullable && m_nodes[right].nullable;
+	else if (kind == Kind::Alternation)
+		nullable = m_nodes[left].nullable || m_nodes[right].nullable;
+	else if (kind == Kind::Plus)
+		nullable = m_nodes[left].nullable;
+	else if (kind != Kind::Symbols)
+		nullable = true;
+	m_nodes.push_back({ kind, left, right, charClass, nullable });
+	return it->second;
+}
+
+/// <summary>
+/// the unary node of this kind over left if it exists, kNone otherwise; nothing is created
+/// </summary>
+/// <param name="kind"></param>
+/// <param name="left"></param>
+/// <returns></returns>
+RegexTree::NodeId RegexTree::find(Kind kind, NodeId left) const {
+	auto it = m_ids.find({ static_cast<std::uint64_t>(left) << 32 | kNone, kNone, kind });
+	return it == m_ids.end() ? kNone : it->second;
+}
+
+RegexTree::NodeId RegexTree::symbols(const CharClass& charClass) {
+	std::string ranges;
+	for (const CharClass::Range& range : charClass.ranges()) {
+		ranges += static_cast<char>(range.first);
+		ranges += static_cast<char>(range.last);
+	}
+	auto [it, inserted] = m_classIds.emplace(ranges, static_cast<std::uint32_t>(m_classes.size()));
+	if (inserted)
+		m_classes.push_back(charClass);
+	return intern(Kind::Symbols, kNone, kNone, it->second);
+}
+
+/// <summary>
+/// reads an expression in polish form (as returned by infixToPostfix); every byte that is not an operator or the
+/// start of a class is a symbol, like in NFABuilder::fromPostfix. An invalid expression gives a tree without a root
+/// </summary>
+/// <param name="polishForm"></param>
+/// <returns></returns>
+RegexTree RegexTree::fromPostfix(const std::string& polishForm) {
+	RegexTree tree;
+	std::vector<NodeId> stack;
+	for (std::size_t i = 0; i < polishForm.size(); i++) {
+		const char symbol = polishForm[i];
+		const std::size_t operands = symbol == '.' || symbol == '|' ? 2 : symbol == '*' || symbol == '+' || symbol == '?' ? 1 : 0;
+		if (stack.size() < operands)
+			return RegexTree();
+		if (operands == 0) {
+			const std::size_t end = CharClass::operandEnd(polishForm, i);
+			CharClass charClass;
+			if (!CharClass::parse(polishForm, i, end, charClass))
+				return RegexTree();
+			stack.push_back(tree.symbols(charClass));
+			i = end - 1;
+			continue;
+		}
+		const NodeId b = stack.back();
+		if (operands == 2)
+			stack.pop_back();
+		NodeId& a = stack.back();
+		if (symbol == '.')
+			a = tree.intern(Kind::Concatenation, a, b);
+		else if (symbol == '|')
+			a = tree.intern(Kind::Alternation, a, b);
+		else
+			a = tree.intern(symbol == '*' ? Kind::Star : symbol == '+' ? Kind::Plus : Kind::Optional, a);
+	}
+	if (stack.size() != 1)
+		return RegexTree();
+	tree.m_root = stack.back();
+	return tree;
+}
+
+RegexTree::NodeId RegexTree::star(NodeId a) {
+	const Node& node = m_nodes[a];
+	if (node.kind == Kind::Star)
+		return a;
+	if (node.kind == Kind::Plus || node.kind == Kind::Optional)
+		return star(node.left);
+	if (node.kind == Kind::Alternation) { // (x*|y)* = (x|y)*: repeating already gives the repetitions of every branch
+		std::vector<NodeId> branches;
+		collect(a, Kind::Alternation, branches);
+		bool changed = false;
+		for (NodeId& branch : branches)
+			if (m_nodes[branch].kind == Kind::Star || m_nodes[branch].kind == Kind::Plus || m_nodes[branch].kind == Kind::Optional) {
+				branch = m_nodes[branch].left;
+				changed = true;
+			}
+		if (changed)
+			return star(alternation(std::move(branches)));
+	}
+	return intern(Kind::Star, a);
+}
+
+RegexTree::NodeId RegexTree::plus(NodeId a) {
+	const Node& node = m_nodes[a];
+	if (node.kind == Kind::Plus)
+		return a;
+	if (node.nullable) // (a*)+ = a*, and a+ accepts the empty word anyway
+		return star(a);
+	return intern(Kind::Plus, a);
+}
+
+RegexTree::NodeId RegexTree::optional(NodeId a) {
+	const Node& node = m_nodes[a];
+	if (node.nullable)
+		return a;
+	if (node.kind == Kind::Plus) // (a+)? = a*
+		return star(node.left);
+	return intern(Kind::Optional, a);
+}
+
+/// <summary>
+/// concatenations are kept as right leaning chains, so the first factor of a chain is its left child
+/// </summary>
+/// <param name="a"></param>
+/// <param name="b"></param>
+/// <returns></returns>
+RegexTree::NodeId RegexTree::concatenate(NodeId a, NodeId b) {
+	if (m_nodes[a].kind == Kind::Concatenation)
+		return concatenate(m_nodes[a].left, concatenate(m_nodes[a].right, b));
+	const NodeId head = m_nodes[b].kind == Kind::Concatenation ? m_nodes[b].left : b;
+	const NodeId rest = m_nodes[b].kind == Kind::Concatenation ? m_nodes[b].right : kNone;
+	auto withRest = [&](NodeId merged) { return rest == kNone ? merged : concatenate(merged, rest); };
+	const Node& first = m_nodes[a];
+	const Node& second = m_nodes[head];
+	if (first.kind == Kind::Star && (second.kind == Kind::Star || second.kind == Kind::Optional) && first.left == second.left) // a*.a* and a*.a?
+		return withRest(a);
+	if (first.kind == Kind::Optional && second.kind == Kind::Star && first.left == second.left) // a?.a*
+		return withRest(head);
+	if ((second.kind == Kind::Star && second.left == a) || (first.kind == Kind::Star && first.left == head)) // a.a* and a*.a
+		return withRest(plus(first.kind == Kind::Star ? first.left : a));
+	if ((first.kind == Kind::Plus && second.kind == Kind::Star && first.left == second.left) // a+.a* and a*.a+
+		|| (first.kind == Kind::Star && second.kind == Kind::Plus && first.left == second.left))
+		return withRest(plus(first.left));
+	return intern(Kind::Concatenation, a, b);
+}
+
+/// <summary>
+/// alternation of the simplified branches: drops duplicates and branches implied by a repetition of themselves,
+/// factors common first factors out and merges the single symbol branches into one class. Branches are kept in
+/// increasing order of their ids, so equal alternations get the same node whatever order they were written in
+/// </summary>
+/// <param name="branches"></param>
+/// <returns></returns>
+RegexTree::NodeId RegexTree::alternation(std::vector<NodeId> branches) {
+	std::vector<NodeId> flat;
+	for (const NodeId branch : branches)
+		collect(branch, Kind::Alternation, flat);
+	std::sort(flat.begin(), flat.end());
+	flat.erase(std::unique(flat.begin(), flat.end()), flat.end());
+	auto present = [&](NodeId node) { return node != kNone && std::binary_search(flat.begin(), flat.end(), node); };
+	std::vector<NodeId> kept;
+	for (const NodeId branch : flat) { // x next to x*, x+ or x?, and x+ or x? next to x*
+		const Node& node = m_nodes[branch];
+		const bool implied = present(find(Kind::Star, branch)) || present(find(Kind::Plus, branch)) || present(find(Kind::Optional, branch))
+			|| ((node.kind == Kind::Plus || node.kind == Kind::Optional) && present(find(Kind::Star, node.left)));
+		if (!implied)
+			kept.push_back(branch);
+	}
+
+	std::vector<NodeId> result;
+	std::vector<bool> used(kept.size(), false);
+	auto headOf = [&](NodeId node) { return m_nodes[node].kind == Kind::Concatenation ? m_nodes[node].left : node; };
+	for (std::size_t i = 0; i < kept.size(); i++) {
+		if (used[i])
+			continue;
+		const NodeId head = headOf(kept[i]);
+		std::vector<NodeId> tails;
+		bool emptyTail = false; // head itself is a branch
+		std::size_t groupSize = 0;
+		for (std::size_t j = i; j < kept.size(); j++)
+			if (!used[j] && headOf(kept[j]) == head) {
+				used[j] = true;
+				groupSize++;
+				if (kept[j] == head)
+					emptyTail = true;
+				else
+					tails.push_back(m_nodes[kept[j]].right);
+			}
+		if (groupSize == 1) {
+			result.push_back(kept[i]);
+			continue;
+		}
+		const NodeId tail = alternation(std::move(tails));
+		result.push_back(concatenate(head, emptyTail ? optional(tail) : tail));
+	}
+
+	CharClass merged; // every single symbol branch
+	std::size_t symbolBranches = 0;
+	for (const NodeId branch : result)
+		if (m_nodes[branch].kind == Kind::Symbols) {
+			for (const CharClass::Range& range : m_classes[m_nodes[branch].charClass].ranges())
+				merged.add(range.first, range.last);
+			symbolBranches++;
+		}
+	std::string written;
+	if (symbolBranches > 1 && writeClass(merged, written)) {
+		result.erase(std::remove_if(result.begin(), result.end(), [&](NodeId branch) { return m_nodes[branch].kind == Kind::Symbols; }), result.end());
+		result.push_back(symbols(merged));
+	}
+	std::sort(result.begin(), result.end());
+	result.erase(std::unique(result.begin(), result.end()), result.end());
+
+	NodeId chain = result.back();
+	for (std::size_t i = result.size() - 1; i-- > 0;)
+		chain = intern(Kind::Alternation, result[i], chain);
+	return chain;
+}
+
+/// <summary>
+/// appends the operands of the maximal subtree of nodes of the given kind rooted at node, left to right
+/// </summary>
+/// <param name="node"></param>
+/// <param name="kind"></param>
+/// <param name="operands"></param>
+void RegexTree::collect(NodeId node, Kind kind, std::vector<NodeId>& operands) const {
+	std::vector<NodeId> pending{ node }; // explicit stack, long chains would overflow the call stack
+	while (!pending.empty()) {
+		const NodeId current = pending.back();
+		pending.pop_back();
+		if (m_nodes[current].kind == kind) {
+			pending.push_back(m_nodes[current].right);
+			pending.push_back(m_nodes[current].left);
+		}
+		else
+			operands.push_back(current);
+	}
+}
+
+/// <summary>
+/// simplified form of a node of the parsed tree; every node is simplified once
+/// </summary>
+/// <param name="node"></param>
+/// <returns></returns>
+RegexTree::NodeId RegexTree::simplify(NodeId node) {
+	if (auto it = m_simplified.find(node); it != m_simplified.end())
+		return it->second;
+	const Node current = m_nodes[node];
+	NodeId result = node;
+	if (current.kind == Kind::Star)
+		result = star(simplify(current.left));
+	else if (current.kind == Kind::Plus)
+		result = plus(simplify(current.left));
+	else if (current.kind == Kind::Optional)
+		result = optional(simplify(current.left));
+	else if (current.kind == Kind::Concatenation) {
+		std::vector<NodeId> factors;
+		collect(node, Kind::Concatenation, factors);
+		result = simplify(factors.back());
+		for (std::size_t i = factors.size() - 1; i-- > 0;)
+			result = concatenate(simplify(factors[i]), result);
+	}
+	else if (current.kind == Kind::Alternation) {
+		std::vector<NodeId> branches;
+		collect(node, Kind::Alternation, branches);
+		for (NodeId& branch : branches)
+			branch = simplify(branch);
+		result = alternation(std::move(branches));
+	}
+	m_simplified[node] = result;
+	return result;
+}
+
+/// <summary>
+/// copy of the tree whose root is the rewritten expression, rewritten again while that still changes it
+/// </summary>
+/// <returns></returns>
+RegexTree RegexTree::simplified() const {
+	RegexTree result = *this;
+	for (int pass = 0; pass < kMaxPasses && result.isValid(); pass++) { // a rewrite can make another one possible
+		const NodeId root = result.simplify(result.m_root);
+		if (root == result.m_root)
+			break;
+		result.m_root = root;
+	}
+	return result;
+}
+
+/// <summary>
+/// writes a class the way CharClass::parse reads it: a single letter or digit as itself, anything else in brackets
+/// with ] first and ^ and - last. Returns false for a class that cannot be written: an empty one, or only ^ (and -)
+/// </summary>
+/// <param name="charClass"></param>
+/// <param name="out"></param>
+/// <returns></returns>
+bool RegexTree::writeClass(const CharClass& charClass, std::string& out) {
+	const auto& ranges = charClass.ranges();
+	if (ranges.empty())
+		return false;
+	if (ranges.size() == 1 && ranges[0].first == ranges[0].last) {
+		const char c = static_cast<char>(ranges[0].first);
+		if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')) {
+			out += c;
+			return true;
+		}
+	}
+	auto special = [](unsigned int byte) { return byte == ']' || byte == '^' || byte == '-'; };
+	std::string body; // every byte but ], ^ and -, which are written on their own
+	for (const CharClass::Range& range : ranges)
+		for (unsigned int first = range.first; first <= range.last; first++) {
+			if (special(first))
+				continue;
+			unsigned int last = first;
+			while (last < range.last && !special(last + 1))
+				last++;
+			body += static_cast<char>(first);
+			if (last > first + 1)
+				body += '-';
+			if (last > first)
+				body += static_cast<char>(last);
+			first = last;
+		}
+	const bool bracket = charClass.contains(']'), caret = charClass.contains('^'), dash = charClass.contains('-');
+	if (caret && !bracket && body.empty()) // [^] and [^-] mean something else
+		return false;
+	out += '[';
+	if (bracket)
+		out += ']';
+	out += body;
+	if (caret)
+		out += '^';
+	if (dash)
+		out += '-';
+	out += ']';
+	return true;
+}
+
+bool RegexTree::writePostfix(NodeId node, std::string& out) const {
+	const Node& current = m_nodes[node];
+	switch (current.kind) {
+	case Kind::Symbols:
+		return writeClass(m_classes[current.charClass], out);
+	case Kind::Concatenation:
+	case Kind::Alternation:
+		if (!writePostfix(current.left, out) || !writePostfix(current.right, out))
+			return false;
+		out += current.kind == Kind::Concatenation ? '.' : '|';
+		return true;
+	default:
+		if (!writePostfix(current.left, out))
+			return false;
+		out += current.kind == Kind::Star ? '*' : current.kind == Kind::Plus ? '+' : '?';
+		return true;
+	}
+}
+
+/// <summary>
+/// context is the precedence of the parent: 1 alternation, 2 concatenation, 3 repetition; a node binding weaker
+/// than its context is put in parentheses
+/// </summary>
+bool RegexTree::writeInfix(NodeId node, int context, std::string& out) const {
+	const Node& current = m_nodes[node];
+	if (current.kind == Kind::Symbols)
+		return writeClass(m_classes[current.charClass], out);
+	const int precedence = current.kind == Kind::Alternation ? 1 : current.kind == Kind::Concatenation ? 2 : 3;
+	if (precedence < context)
+		out += '(';
+	bool written;
+	if (precedence < 3) {
+		written = writeInfix(current.left, precedence, out);
+		out += current.kind == Kind::Concatenation ? '.' : '|';
+		written = written && writeInfix(current.right, precedence, out);
+	}
+	else {
+		written = writeInfix(current.left, 4, out); // (a*)* style nesting is kept explicit
+		out += current.kind == Kind::Star ? '*' : current.kind == Kind::Plus ? '+' : '?';
+	}
+	if (precedence < context)
+		out += ')';
+	return written;
+}
+
+/// <summary>
+/// writes the tree in polish form, readable by every builder; returns false if the tree is invalid or holds a class
+/// writeClass cannot write
+/// </summary>
+/// <param name="polishForm"></param>
+/// <returns></returns>
+bool RegexTree::toPostfix(std::string& polishForm) const {
+	polishForm.clear();
+	return isValid() && writePostfix(m_root, polishForm);
+}
+
+/// <summary>
+/// writes the tree as an expression infixToPostfix reads back, with only the parentheses it needs
+/// </summary>
+/// <param name="expression"></param>
+/// <returns></returns>
+bool RegexTree::toInfix(std::string& expression) const {
+	expression.clear();
+	return isValid() && writeInfix(m_root, 0, expression);
+}
+
+/// <summary>
+/// number of operands and operators of the expression, that is the size of the tree with its shared nodes repeated
+/// </summary>
+/// <returns></returns>
+std::size_t RegexTree::treeSize() const {
+	if (!isValid())
+		return 0;
+	std::vector<std::size_t> size(m_nodes.size(), 0); // children are always created before their parents
+	for (NodeId node = 0; node < m_nodes.size(); node++) {
+		const Node& current = m_nodes[node];
+		size[node] = 1;
+		if (current.left != kNone)
+			size[node] += size[current.left];
+		if (current.right != kNone)
+			size[node] += size[current.right];
+	}
+	return size[m_root];
+}
+
+/// <summary>
+/// the rewritten polish form of an expression, or polishForm itself if it is invalid, so the builders report it
+/// as they did before
+/// </summary>
+/// <param name="polishForm"></param>
+/// <returns></returns>
+std::string RegexTree::simplify(const std::string& polishForm) {
+	STATS_PHASE(Simplification);
+	const RegexTree parsed = fromPostfix(polishForm);
+	const RegexTree tree = parsed.simplified();
+	std::string result;
+	if (!tree.toPostfix(result))
+		return polishForm;
+	STATS_ADD(termsBeforeSimplification, parsed.treeSize());
+	STATS_ADD(termsAfterSimplification, tree.treeSize());
+	return result;
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "CharClass.h"
+
+/// <summary>
+/// sizes of the automata of an expression built from its polish form as written and after the RegexTree rewrites.
+/// Both forms accept the same words, so their minimized dfas are the same; the dfa counts are taken before minimization
+/// </summary>
+struct SimplificationStats
+{
+	std::size_t nfaStatesBefore = 0;
+	std::size_t nfaStatesAfter = 0;
+	std::size_t dfaStatesBefore = 0;
+	std::size_t dfaStatesAfter = 0;
+};
+
+/// <summary>
+/// syntax tree of an expression in polish form where equal sub-expressions are stored once (hash consing), so two
+/// sub-expressions are equal exactly when their ids are. simplified() rewrites the tree bottom up into a smaller one
+/// accepting the same words:
+///   (a*)* (a+)* (a?)* (a*)+ (a*)? ... -> a*, (a+)+ -> a+, a? -> a when a accepts the empty word
+///   a.a* a*.a -> a+, a*.a* a*.a? a?.a* -> a*
+///   alternations are flattened, duplicate branches dropped, a next to a* a+ or a? dropped, common prefixes
+///   factored out (x|x.y -> x.y?, a.b|a.c -> a.(b|c)) and single symbol branches merged into one class (a|b|[0-9] -> [0-9ab])
+/// </summary>
+class RegexTree
+{
+public:
+	using NodeId = std::uint32_t;
+	static constexpr NodeId kNone = UINT32_MAX;
+	static constexpr int kMaxPasses = 4;
+
+	enum class Kind : std::uint8_t
+	{
+		Symbols, // one operand: a symbol or a class
+		Concatenation,
+		Alternation,
+		Star,
+		Plus,
+		Optional
+	};
+
+protected:
+	struct Node
+	{
+		Kind kind;
+		NodeId left; // the operand of the unary operators
+		NodeId right;
+		std::uint32_t charClass; // Symbols: index in m_classes
+		bool nullable; // accepts the empty word
+	};
+
+	struct Key
+	{
+		std::uint64_t operands; // left and right
+		std::uint32_t charClass;
+		Kind kind;
+
+		bool operator==(const Key& other) const = default;
+	};
+
+	struct KeyHash
+	{
+		std::size_t operator()(const Key& key) const;
+	};
+
+	std::vector<Node> m_nodes;
+	std::unordered_map<Key, NodeId, KeyHash> m_ids;
+	std::vector<CharClass> m_classes;
+	std::unordered_map<std::string, std::uint32_t> m_classIds; // ranges of a class -> its index
+	std::unordered_map<NodeId, NodeId> m_simplified; // node -> its simplified form
+	NodeId m_root = kNone;
+
+	NodeId intern(Kind kind, NodeId left, NodeId right = kNone, std::uint32_t charClass = kNone);
+	NodeId find(Kind kind, NodeId left) const;
+	NodeId symbols(const CharClass& charClass);
+
+	NodeId star(NodeId a);
+	NodeId plus(NodeId a);
+	NodeId optional(NodeId a);
+	NodeId concatenate(NodeId a, NodeId b);
+	NodeId alternation(std::vector<NodeId> branches);
+	NodeId simplify(NodeId node);
+
+	void collect(NodeId node, Kind kind, std::vector<NodeId>& operands) const;
+	bool writePostfix(NodeId node, std::string& out) const;
+	bool writeInfix(NodeId node, int context, std::string& out) const;
+
+public:
+	static RegexTree fromPostfix(const std::string& polishForm);
+	static bool writeClass(const CharClass& charClass, std::string& out);
+	static std::string simplify(const std::string& polishForm);
+
+	RegexTree simplified() const;
+	bool toPostfix(std::string& polishForm) const;
+	bool toInfix(std::string& expression) const;
+
+	bool isValid() const { return m_root != kNone; }
+	NodeId root() const { return m_root; }
+	std::size_t nodeCount() const { return m_nodes.size(); }
+	std::size_t treeSize() const;
+};
@@ -0,0 +1,267 @@
+#include "Searcher.h"
+#include "ParallelMatcher.h"
+#include "PerformanceStats.h"
+
+/// <summary>
+/// builds the minimized dfas used by the search
+/// </summary>
+/// <param name="nfa"></param>
+/// <param name="prefilter"></param>
+Searcher::Searcher(const IndexedNFA& nfa, Prefilter prefilter)
+	: m_unanchored(CompiledDFA::fromNFA(nfa, true).minimize()),
+	m_reverse(CompiledDFA::fromNFA(nfa.reversed()).minimize()),
+	m_reversePrefixes(CompiledDFA::fromNFA(nfa.reversedPrefixes()).minimize()),
+	m_anchored(CompiledDFA::fromNFA(nfa).minimize()),
+	m_prefilter(std::move(prefilter)) {
+}
+
+/// <summary>
+/// runs the reversed dfa backwards from end and returns the smallest start (not below lowerBound) of a match ending at end
+/// </summary>
+/// <param name="text"></param>
+/// <param name="end"></param>
+/// <param name="lowerBound"></param>
+/// <returns></returns>
+std::size_t Searcher::findStart(std::string_view text, std::size_t end, std::size_t lowerBound) const {
+	CompiledDFA::State state = m_reverse.initialState();
+	std::size_t start = end;
+	for (std::size_t i = end; i > lowerBound;) {
+		state = m_reverse.next(state, static_cast<unsigned char>(text[--i]));
+		if (state == CompiledDFA::kDeadState)
+			break;
+		if (m_reverse.isAccepting(state))
+			start = i;
+	}
+	return start;
+}
+
+/// <summary>
+/// same as findStart with no lower bound, but the walk stops where it meets a cached walk in the same state
+/// </summary>
+/// <param name="text"></param>
+/// <param name="end"></param>
+/// <param name="cache"></param>
+/// <returns></returns>
+std::size_t Searcher::findStart(std::string_view text, std::size_t end, StartCache& cache) const {
+	CompiledDFA::State state = m_reverse.initialState();
+	std::size_t start = end;
+	std::vector<CompiledDFA::State>& walk = cache.walk;
+	walk.clear();
+	const std::size_t top = cache.base + cache.states.size();
+	bool merged = false;
+	for (std::size_t i = end; i > 0;) {
+		state = m_reverse.next(state, static_cast<unsigned char>(text[--i]));
+		if (state == CompiledDFA::kDeadState)
+			break;
+		if (i >= cache.base && i < top && cache.states[i - cache.base] == state) {
+			if (cache.earliest[i - cache.base] != StartCache::kNone)
+				start = cache.earliest[i - cache.base];
+			merged = walk.size() < StartCache::kMaxEntries; // a longer walk is not recorded down to here
+			break;
+		}
+		if (m_reverse.isAccepting(state))
+			start = i;
+		if (walk.size() < StartCache::kMaxEntries)
+			walk.push_back(state);
+	}
+
+	const std::size_t low = end - walk.size(); // lowest recorded position; a merged walk continues the cache below it
+	if (merged) {
+		cache.states.resize(low - cache.base);
+		cache.earliest.resize(low - cache.base);
+	}
+	else {
+		cache.base = low;
+		cache.states.clear();
+		cache.earliest.clear();
+	}
+	std::size_t earliest = start < low ? start : StartCache::kNone;
+	for (std::size_t position = low; position < end; position++) {
+		const CompiledDFA::State recorded = walk[end - 1 - position];
+		if (earliest == StartCache::kNone && m_reverse.isAccepting(recorded))
+			earliest = position;
+		cache.states.push_back(recorded);
+		cache.earliest.push_back(earliest);
+	}
+	if (cache.states.size() > 2 * StartCache::kMaxEntries) { // only the positions near the next ends are useful
+		const std::size_t dropped = cache.states.size() - StartCache::kMaxEntries;
+		cache.states.erase(cache.states.begin(), cache.states.begin() + dropped);
+		cache.earliest.erase(cache.earliest.begin(), cache.earliest.begin() + dropped);
+		cache.base += dropped;
+	}
+	return start;
+}
+
+/// <summary>
+/// leftmost start (not below lowerBound) of a non empty match, given the first end of a match after lowerBound and
+/// the smallest start of a match ending there. A match starting before start has to end after end, so text[s, end)
+/// is a prefix of it: the reversed prefixes dfa walks back from end to every such s, and the anchored dfa checks
+/// them from the leftmost one
+/// </summary>
+/// <param name="text"></param>
+/// <param name="lowerBound"></param>
+/// <param name="start"></param>
+/// <param name="end"></param>
+/// <returns></returns>
+std::size_t Searcher::findLeftmostStart(std::string_view text, std::size_t lowerBound, std::size_t start, std::size_t end) const {
+	if (start == lowerBound)
+		return start;
+	std::vector<std::size_t> candidates; // decreasing
+	CompiledDFA::State state = m_reversePrefixes.initialState();
+	for (std::size_t i = end; i > lowerBound;) {
+		state = m_reversePrefixes.next(state, static_cast<unsigned char>(text[--i]));
+		if (state == CompiledDFA::kDeadState)
+			break;
+		if (i < start && m_reversePrefixes.isAccepting(state))
+			candidates.push_back(i);
+	}
+	for (auto it = candidates.rbegin(); it != candidates.rend(); ++it)
+		if (findLongestEnd(text, *it, *it) > *it)
+			return *it;
+	return start;
+}
+
+/// <summary>
+/// runs the anchored dfa from start and returns the end of the longest match, which is at least end
+/// </summary>
+/// <param name="text"></param>
+/// <param name="start"></param>
+/// <param name="end"></param>
+/// <returns></returns>
+std::size_t Searcher::findLongestEnd(std::string_view text, std::size_t start, std::size_t end) const {
+	CompiledDFA::State state = m_anchored.initialState();
+	std::size_t longest = end;
+	for (std::size_t i = start; i < text.size();) {
+		state = m_anchored.next(state, static_cast<unsigned char>(text[i++]));
+		if (state == CompiledDFA::kDeadState)
+			break;
+		if (m_anchored.isAccepting(state) && i > longest)
+			longest = i;
+	}
+	return longest;
+}
+
+/// <summary>
+/// all-matches scan of the ends in [from, to), with the unanchored dfa in the given state at from; matches may start
+/// before from. Returns the number of matches
+/// </summary>
+/// <param name="text"></param>
+/// <param name="from"></param>
+/// <param name="to"></param>
+/// <param name="state"></param>
+/// <param name="onMatch"></param>
+/// <returns></returns>
+std::size_t Searcher::scanAllMatches(std::string_view text, std::size_t from, std::size_t to, CompiledDFA::State state, const std::function<void(const Match&)>& onMatch) const {
+	const CompiledDFA::State initial = m_unanchored.initialState();
+	std::size_t count = 0;
+	std::size_t occurrence = Prefilter::npos;
+	StartCache cache;
+	for (std::size_t i = from; i < to;) {
+		if (state == initial && !m_prefilter.empty()) { // no match in progress, so the next one cannot start before the candidate
+			i = m_prefilter.nextCandidate(text, i, to, occurrence);
+			if (i >= to)
+				break;
+		}
+		const CompiledDFA::State previous = state;
+		state = m_unanchored.next(state, static_cast<unsigned char>(text[i++]));
+		if (!m_unanchored.isAccepting(state)) {
+			if (state == previous && m_unanchored.isAccelerable(state)) // no match ends before its next exit byte
+				i = m_unanchored.findExit(state, text.data(), i, to);
+			continue;
+		}
+		const std::size_t start = findStart(text, i, cache);
+		if (start < i) {
+			onMatch({ start, i });
+			count++;
+		}
+	}
+	return count;
+}
+
+/// <summary>
+/// calls onMatch for every match in text, in increasing order of the end offset, and returns how many there were
+/// </summary>
+/// <param name="text"></param>
+/// <param name="mode"></param>
+/// <param name="onMatch"></param>
+/// <returns></returns>
+std::size_t Searcher::search(std::string_view text, SearchMode mode, const std::function<void(const Match&)>& onMatch) const {
+	STATS_PHASE(Matching);
+	STATS_ADD(bytesScanned, text.size());
+	std::size_t count = 0;
+	if (mode == SearchMode::AllMatches) {
+		count = scanAllMatches(text, 0, text.size(), m_unanchored.initialState(), onMatch);
+		STATS_ADD(matchesFound, count);
+		return count;
+	}
+
+	const CompiledDFA::State initial = m_unanchored.initialState();
+	std::size_t occurrence = Prefilter::npos;
+	std::size_t position = 0; // matches may not start before the end of the previous one
+	while (position < text.size()) {
+		CompiledDFA::State state = initial;
+		Match match{ 0, 0 };
+		for (std::size_t i = position; i < text.size();) {
+			if (state == initial && !m_prefilter.empty()) {
+				i = m_prefilter.nextCandidate(text, i, text.size(), occurrence);
+				if (i == Prefilter::npos)
+					break;
+			}
+			const CompiledDFA::State previous = state;
+			state = m_unanchored.next(state, static_cast<unsigned char>(text[i++]));
+			if (!m_unanchored.isAccepting(state)) {
+				if (state == previous && m_unanchored.isAccelerable(state))
+					i = m_unanchored.findExit(state, text.data(), i, text.size());
+				continue;
+			}
+			const std::size_t start = findStart(text, i, position);
+			if (start < i) { // first non empty match end after position
+				match = { start, i };
+				break;
+			}
+		}
+		if (match.end == 0)
+			break;
+		match.start = findLeftmostStart(text, position, match.start, match.end);
+		match.end = findLongestEnd(text, match.start, match.end);
+		onMatch(match);
+		count++;
+		position = match.end;
+	}
+	STATS_ADD(matchesFound, count);
+	return count;
+}
+
+std::vector<Match> Searcher::findAll(std::string_view text, SearchMode mode) const {
+	std::vector<Match> matches;
+	search(text, mode, [&](const Match& match) { matches.push_back(match); });
+	return matches;
+}
+
+/// <summary>
+/// the all-matches search on every thread of the pool: ParallelMatcher gives the state of the unanchored dfa at
+/// every chunk boundary, then every chunk is scanned from its exact state. onMatch is called on the calling thread,
+/// in the same order as search does
+/// </summary>
+/// <param name="text"></param>
+/// <param name="pool"></param>
+/// <param name="onMatch"></param>
+/// <returns></returns>
+std::size_t Searcher::searchParallel(std::string_view text, ThreadPool& pool, const std::function<void(const Match&)>& onMatch) const {
+	STATS_PHASE(Matching);
+	STATS_ADD(bytesScanned, text.size());
+	const std::vector<std::size_t> bounds = ParallelMatcher::chunkBounds(text.size(), pool);
+	const std::vector<CompiledDFA::State> states = ParallelMatcher::boundaryStates(m_unanchored, text, bounds, pool);
+	std::vector<std::vector<Match>> chunkMatches(bounds.size() - 1);
+	pool.run(chunkMatches.size(), [&](std::size_t chunk) {
+		scanAllMatches(text, bounds[chunk], bounds[chunk + 1], states[chunk], [&](const Match& match) { chunkMatches[chunk].push_back(match); });
+	});
+	std::size_t count = 0;
+	for (const auto& matches : chunkMatches)
+		for (const Match& match : matches) {
+			onMatch(match);
+			count++;
+		}
+	STATS_ADD(matchesFound, count);
+	return count;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <functional>
+#include <string_view>
+#include <vector>
+#include "CompiledDFA.h"
+#include "ThreadPool.h"
+#include "IndexedNFA.h"
+#include "Prefilter.h"
+
+enum class SearchMode
+{
+	AllMatches, // every offset where a match ends, with the leftmost start of a match ending there; matches may overlap
+	LeftmostLongest // non overlapping matches, each one taken as long as possible
+};
+
+struct Match
+{
+	std::size_t start; // offset of the first byte
+	std::size_t end; // offset one past the last byte
+};
+
+/// <summary>
+/// unanchored search: finds the occurrences of an expression inside a larger text, as if it was prefixed by any string.
+/// A forward unanchored dfa finds where matches end and a dfa of the reversed expression walks back from there to the start.
+/// In leftmost-longest mode a match starting further left may end later: a dfa of the reversed prefixes of the
+/// expression walks back from the first end to the starts of such matches, and an anchored dfa extends the leftmost
+/// one as far as it goes. Empty matches are not reported.
+/// When the expression requires a literal, the forward scan jumps over the bytes where no match can start whenever
+/// the unanchored dfa is back in its initial state, and a non final state that only leaves on a few bytes skips to
+/// the next of them (see CompiledDFA::computeAcceleration).
+/// </summary>
+class Searcher
+{
+protected:
+	/// <summary>
+	/// states of the recent walks of the reversed dfa by position: a later walk reaching one of these positions in
+	/// the same state goes on exactly like the cached one, so it stops there and takes the cached result. This keeps
+	/// the all-matches scan linear on long runs like [a-z]+ over a line of letters, where every walk would otherwise
+	/// go back to the start of the run
+	/// </summary>
+	struct StartCache
+	{
+		static constexpr std::size_t kNone = SIZE_MAX;
+		static constexpr std::size_t kMaxEntries = std::size_t(1) << 16; // positions kept, at most twice as many in between trims
+
+		std::size_t base = 0; // position of the first entry
+		std::vector<CompiledDFA::State> states; // state after reading the byte at base + k
+		std::vector<std::size_t> earliest; // smallest accepting position at or below base + k on that walk, kNone if there is none
+		std::vector<CompiledDFA::State> walk; // states of the current walk, from its end down
+	};
+
+	CompiledDFA m_unanchored;
+	CompiledDFA m_reverse;
+	CompiledDFA m_reversePrefixes;
+	CompiledDFA m_anchored;
+	Prefilter m_prefilter;
+
+	std::size_t findStart(std::string_view text, std::size_t end, std::size_t lowerBound) const;
+	std::size_t findStart(std::string_view text, std::size_t end, StartCache& cache) const;
+	std::size_t findLeftmostStart(std::string_view text, std::size_t lowerBound, std::size_t start, std::size_t end) const;
+	std::size_t findLongestEnd(std::string_view text, std::size_t start, std::size_t end) const;
+	std::size_t scanAllMatches(std::string_view text, std::size_t from, std::size_t to, CompiledDFA::State state, const std::function<void(const Match&)>& onMatch) const;
+
+public:
+	explicit Searcher(const IndexedNFA& nfa, Prefilter prefilter = {});
+
+	std::size_t search(std::string_view text, SearchMode mode, const std::function<void(const Match&)>& onMatch) const;
+	std::vector<Match> findAll(std::string_view text, SearchMode mode) const;
+	std::size_t searchParallel(std::string_view text, ThreadPool& pool, const std::function<void(const Match&)>& onMatch) const;
+
+	const Prefilter& prefilter() const { return m_prefilter; }
+	const CompiledDFA& unanchored() const { return m_unanchored; }
+};
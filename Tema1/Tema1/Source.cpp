@@ -2,10 +2,212 @@
 #include <fstream>
 #include <stack>
 #include <string>
+#include <limits>
+#include <vector>
 #include "Automaton.h"
+#include "MappedFile.h"
+#include "BatchMatcher.h"
+#include "MappedDFA.h"
+#ifndef _WIN32
+#include <atomic>
+#include <csignal>
+#include "MatchServer.h"
+#endif
 
-int main()
+/// <summary>
+/// prints the start and end offset of every match of the expression in the file, one match per line
+/// </summary>
+/// <param name="expression"></param>
+/// <param name="path"></param>
+/// <param name="mode"></param>
+/// <returns></returns>
+int runSearch(const std::string& expression, const std::string& path, SearchMode mode)
 {
+	MappedFile file(path);
+	if (!file.isOpen()) {
+		std::cout << "Failed to open " << path << "\n";
+		return 1;
+	}
+	Searcher searcher = Automaton::buildSearcher(expression);
+	std::string buffer; // output is written in large blocks instead of once per match
+	auto write = [&](const Match& match) {
+		buffer += std::to_string(match.start);
+		buffer += ' ';
+		buffer += std::to_string(match.end);
+		buffer += '\n';
+		if (buffer.size() >= (1 << 16)) {
+			std::cout.write(buffer.data(), buffer.size());
+			buffer.clear();
+		}
+	};
+	std::size_t count;
+	if (mode == SearchMode::AllMatches) { // only this mode can be split in independent chunks
+		ThreadPool pool;
+		count = searcher.searchParallel(file.view(), pool, write);
+	}
+	else
+		count = searcher.search(file.view(), mode, write);
+	std::cout.write(buffer.data(), buffer.size());
+	std::cerr << count << " matches\n";
+	return 0;
+}
+
+/// <summary>
+/// reads the file in fixed size buffers through a StreamMatcher and prints the end offset of every match, then
+/// whether the whole file is a word of the expression; memory use does not depend on the size of the file
+/// </summary>
+/// <param name="expression"></param>
+/// <param name="path"></param>
+/// <returns></returns>
+int runStream(const std::string& expression, const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		std::cout << "Failed to open " << path << "\n";
+		return 1;
+	}
+	const StreamPattern pattern = Automaton::buildStreamPattern(expression);
+	StreamMatcher matcher(pattern);
+	std::vector<char> buffer(1 << 16);
+	std::string output;
+	while (file.read(buffer.data(), buffer.size()) || file.gcount() > 0) {
+		matcher.feed(buffer.data(), static_cast<std::size_t>(file.gcount()), [&](std::uint64_t end) {
+			output += std::to_string(end);
+			output += '\n';
+		});
+		std::cout.write(output.data(), output.size());
+		output.clear();
+	}
+	std::cout << (matcher.finish() ? "accepted\n" : "not accepted\n");
+	std::cerr << matcher.matchCount() << " matches\n";
+	return 0;
+}
+
+/// <summary>
+/// classifies every line of the file and prints 1 (accepted) or 0 (not accepted) for each, in one write
+/// </summary>
+/// <param name="expression"></param>
+/// <param name="path"></param>
+/// <returns></returns>
+int runBatch(const std::string& expression, const std::string& path)
+{
+	MappedFile file(path);
+	if (!file.isOpen()) {
+		std::cout << "Failed to open " << path << "\n";
+		return 1;
+	}
+	ThreadPool pool;
+	CompiledDFA dfa = Automaton::buildCompiledDFA(expression, true, nullptr, &pool);
+	std::size_t lineCount = 0;
+	std::vector<std::uint64_t> accepted = BatchMatcher::classifyLines(dfa, file.view(), pool, lineCount);
+	std::string output(lineCount * 2, '\n');
+	for (std::size_t line = 0; line < lineCount; line++)
+		output[line * 2] = BatchMatcher::isSet(accepted, line) ? '1' : '0';
+	std::cout.write(output.data(), output.size());
+	return 0;
+}
+
+/// <summary>
+/// checks words against a dfa saved with --save, matching from the mapped file without rebuilding anything
+/// </summary>
+/// <param name="path"></param>
+/// <param name="words"></param>
+/// <param name="count"></param>
+/// <returns></returns>
+int runCheck(const std::string& path, char* words[], int count)
+{
+	MappedDFA dfa(path);
+	if (!dfa.isOpen()) {
+		std::cout << "Failed to load " << path << "\n";
+		return 1;
+	}
+	for (int i = 0; i < count; i++)
+		if (dfa.matches(words[i]))
+			std::cout << "Word " << words[i] << " is accepted\n";
+		else
+			std::cout << "Word " << words[i] << " is NOT accepted\n";
+	return 0;
+}
+
+/// <summary>
+/// prints the state counts of the expression before and after the RegexTree rewrites the build functions apply
+/// </summary>
+/// <param name="expression"></param>
+/// <param name="out"></param>
+void printSimplification(const std::string& expression, std::ostream& out)
+{
+	const SimplificationStats stats = Automaton::measureSimplification(expression);
+	out << "NFA states: " << stats.nfaStatesBefore << " before simplification, " << stats.nfaStatesAfter << " after\n"
+		<< "DFA states: " << stats.dfaStatesBefore << " before simplification, " << stats.dfaStatesAfter << " after\n";
+}
+
+/// <summary>
+/// builds the minimized dfa of the expression, checks the words and prints the collected statistics as json;
+/// the counters are only filled in when the project is built with TEMA1_STATS
+/// </summary>
+/// <param name="expression"></param>
+/// <param name="words"></param>
+/// <param name="count"></param>
+/// <returns></returns>
+int runStats(const std::string& expression, char* words[], int count)
+{
+	if (!PerformanceStats::kEnabled)
+		std::cerr << "Statistics are disabled, rebuild with TEMA1_STATS defined to collect them\n";
+	PerformanceStats stats;
+	{
+		StatsScope scope(stats);
+		CompiledDFA dfa = Automaton::buildCompiledDFA(expression, true);
+		for (int i = 0; i < count; i++)
+			dfa.matches(words[i]);
+	}
+	std::cout << stats.toJson();
+	return 0;
+}
+
+#ifndef _WIN32
+std::atomic<MatchServer*> g_server{ nullptr }; // stopped by SIGINT and SIGTERM
+
+/// <summary>
+/// compiles the expressions once and answers match and search requests on the Unix domain socket at path until
+/// the process is interrupted; the socket file is removed on the way out
+/// </summary>
+/// <param name="path"></param>
+/// <param name="expressions"></param>
+/// <returns></returns>
+int runServer(const std::string& path, const std::vector<std::string>& expressions)
+{
+	MatchServer server(expressions);
+	if (!server.listen(path)) {
+		std::cout << "Failed to listen on " << path << "\n";
+		return 1;
+	}
+	g_server = &server;
+	struct sigaction action {};
+	action.sa_handler = [](int) {
+		if (MatchServer* server = g_server.load())
+			server->stop();
+	};
+	sigemptyset(&action.sa_mask); // no SA_RESTART, so accept returns when a signal arrives
+	sigaction(SIGINT, &action, nullptr);
+	sigaction(SIGTERM, &action, nullptr);
+	for (std::size_t i = 0; i < expressions.size(); i++) {
+		std::cerr << "Pattern " << i << ": " << expressions[i] << "\n";
+		printSimplification(expressions[i], std::cerr);
+	}
+	std::cerr << "Serving " << server.patternCount() << " patterns on " << path << " with " << server.workerCount() << " workers\n";
+	server.serve();
+	std::signal(SIGINT, SIG_DFL); // a signal during the rest of the shutdown must not reach the server being destroyed
+	std::signal(SIGTERM, SIG_DFL);
+	g_server = nullptr;
+	return 0;
+}
+#endif
+
+int main(int argc, char* argv[])
+{
+	if (argc >= 3 && std::string(argv[1]) == "--check") // Tema1 --check <dfa file> <word>..., does not need Input.txt
+		return runCheck(argv[2], argv + 3, argc - 3);
+
 	std::string expression;
 	std::ifstream fin("Input.txt");
 	std::ofstream fout("Output.txt");
@@ -24,11 +226,37 @@ int main()
 		std::cout << "Invalid regex\n";
 		return 0;
 	}
-	Automaton DFA = Automaton::buildDFA(expression);
+	if (argc >= 3 && std::string(argv[1]) == "--search") // Tema1 --search <file> [--all]
+		return runSearch(expression, argv[2], argc >= 4 && std::string(argv[3]) == "--all" ? SearchMode::AllMatches : SearchMode::LeftmostLongest);
+	if (argc >= 3 && std::string(argv[1]) == "--stream") // Tema1 --stream <file>
+		return runStream(expression, argv[2]);
+	if (argc >= 3 && std::string(argv[1]) == "--batch") // Tema1 --batch <file>
+		return runBatch(expression, argv[2]);
+#ifndef _WIN32
+	if (argc >= 3 && std::string(argv[1]) == "--serve") { // Tema1 --serve <socket> [expression]..., pattern 0 is Input.txt
+		std::vector<std::string> expressions{ expression };
+		expressions.insert(expressions.end(), argv + 3, argv + argc);
+		return runServer(argv[2], expressions);
+	}
+#endif
+	if (argc >= 2 && std::string(argv[1]) == "--stats") // Tema1 --stats [word]...
+		return runStats(expression, argv + 2, argc - 2);
+	if (argc >= 3 && std::string(argv[1]) == "--save") { // Tema1 --save <dfa file>
+		if (!Automaton::buildCompiledDFA(expression, true).save(argv[2])) {
+			std::cout << "Failed to write " << argv[2] << "\n";
+			return 1;
+		}
+		return 0;
+	}
+	printSimplification(expression, std::cout);
+	MinimizationStats stats;
+	Automaton DFA = Automaton::buildDFA(expression, true, &stats);
+	std::cout << "DFA states: " << stats.statesBefore << " before minimization, " << stats.statesAfter << " after\n";
 	if (!DFA.verifyAutomaton(DFA)) {
 		std::cout << "Invalid DFA\n";
 		return 0;
 	}
+	CompiledDFA compiled = DFA.compile();
 
 	char c;
 	do {
@@ -46,7 +274,10 @@ int main()
 			std::cout << "Introduce a word: ";
 			std::string word;
 			std::cin >> word;
-			DFA.checkWord(word);
+			if (compiled.matches(word))
+				std::cout << "Word " << word << " is accepted\n";
+			else
+				std::cout << "Word " << word << " is NOT accepted\n";
 		}
 	} while (c != 'x');
 
@@ -0,0 +1,151 @@
+#include "StateSetTable.h"
+#include "PerformanceStats.h"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+void StateSet::clear() {
+	std::fill(m_words.begin(), m_words.end(), 0);
+}
+
+bool StateSet::empty() const {
+	for (const std::uint64_t word : m_words)
+		if (word != 0)
+			return false;
+	return true;
+}
+
+void StateSet::unite(const StateSet& other) {
+	for (std::size_t i = 0; i < m_words.size(); i++)
+		m_words[i] |= other.m_words[i];
+}
+
+bool StateSet::intersects(const StateSet& other) const {
+	for (std::size_t i = 0; i < m_words.size(); i++)
+		if (m_words[i] & other.m_words[i])
+			return true;
+	return false;
+}
+
+std::size_t StateSet::countTrailingZeros(std::uint64_t word) {
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward64(&index, word);
+	return index;
+#else
+	return static_cast<std::size_t>(__builtin_ctzll(word));
+#endif
+}
+
+StateSetTable::StateSetTable(std::size_t stateCount)
+	: m_wordsPerSet((stateCount + 63) / 64), m_buckets(64, 0) {
+}
+
+/// <summary>
+/// 64 bit mix over the words of a set
+/// </summary>
+/// <param name="words"></param>
+/// <param name="count"></param>
+/// <returns></returns>
+std::uint64_t StateSetTable::hashWords(const std::uint64_t* words, std::size_t count) {
+	std::uint64_t hash = 0x9E3779B97F4A7C15ull;
+	for (std::size_t i = 0; i < count; i++) {
+		hash ^= words[i];
+		hash *= 0xBF58476D1CE4E5B9ull;
+		hash ^= hash >> 31;
+	}
+	return hash;
+}
+
+/// <summary>
+/// doubles the bucket array and reinserts every id using the cached hashes
+/// </summary>
+void StateSetTable::grow() {
+	std::vector<std::uint32_t> buckets(m_buckets.size() * 2, 0);
+	const std::size_t mask = buckets.size() - 1;
+	for (std::uint32_t id = 0; id < m_hashes.size(); id++) {
+		std::size_t slot = m_hashes[id] & mask;
+		while (buckets[slot] != 0)
+			slot = (slot + 1) & mask;
+		buckets[slot] = id + 1;
+	}
+	m_buckets = std::move(buckets);
+}
+
+/// <summary>
+/// returns the id of the set and true if it was not in the table before
+/// </summary>
+/// <param name="set"></param>
+/// <returns></returns>
+std::pair<std::uint32_t, bool> StateSetTable::intern(const StateSet& set) {
+	const std::uint64_t hash = hashWords(set.words(), m_wordsPerSet);
+	const std::size_t mask = m_buckets.size() - 1;
+	std::size_t slot = hash & mask;
+	while (m_buckets[slot] != 0) { // linear probing until the set or an empty bucket is found
+		const std::uint32_t id = m_buckets[slot] - 1;
+		if (m_hashes[id] == hash && std::memcmp(&m_words[id * m_wordsPerSet], set.words(), m_wordsPerSet * sizeof(std::uint64_t)) == 0)
+			return { id, false };
+		STATS_ADD(hashCollisions, 1);
+		slot = (slot + 1) & mask;
+	}
+	const std::uint32_t id = static_cast<std::uint32_t>(m_hashes.size());
+	m_words.insert(m_words.end(), set.words(), set.words() + m_wordsPerSet);
+	m_hashes.push_back(hash);
+	m_buckets[slot] = id + 1;
+	if (m_hashes.size() * 2 > m_buckets.size()) // keeps the load factor under one half
+		grow();
+	return { id, true };
+}
+
+std::uint32_t StateSetTable::find(const StateSet& set) const {
+	const std::uint64_t hash = hashWords(set.words(), m_wordsPerSet);
+	const std::size_t mask = m_buckets.size() - 1;
+	for (std::size_t slot = hash & mask; m_buckets[slot] != 0; slot = (slot + 1) & mask) {
+		const std::uint32_t id = m_buckets[slot] - 1;
+		if (m_hashes[id] == hash && std::memcmp(&m_words[id * m_wordsPerSet], set.words(), m_wordsPerSet * sizeof(std::uint64_t)) == 0)
+			return id;
+		STATS_ADD(hashCollisions, 1);
+	}
+	return kNotFound;
+}
+
+/// <summary>
+/// copies the set with the given id into out
+/// </summary>
+/// <param name="id"></param>
+/// <param name="out"></param>
+void StateSetTable::load(std::uint32_t id, StateSet& out) const {
+	std::copy_n(&m_words[id * m_wordsPerSet], m_wordsPerSet, out.words());
+}
+
+ShardedStateSetTable::ShardedStateSetTable(std::size_t stateCount) {
+	for (std::size_t i = 0; i < kShardCount; i++)
+		m_shards.push_back(std::make_unique<Shard>(stateCount));
+}
+
+/// <summary>
+/// thread safe intern; returns the key of the set and whether it was added by this call
+/// </summary>
+/// <param name="set"></param>
+/// <returns></returns>
+std::pair<std::uint64_t, bool> ShardedStateSetTable::intern(const StateSet& set) {
+	const std::size_t shard = static_cast<std::size_t>(StateSetTable::hash(set) >> (64 - kShardBits));
+	std::lock_guard<std::mutex> lock(m_shards[shard]->mutex);
+	const auto [id, inserted] = m_shards[shard]->table.intern(set);
+	return { (static_cast<std::uint64_t>(id) << kShardBits) | shard, inserted };
+}
+
+/// <summary>
+/// once no thread is interning anymore: the first dense index of every shard, so that
+/// denseBases()[shardOf(key)] + idOf(key) numbers the sets 0..size-1; the last entry is the total size
+/// </summary>
+/// <returns></returns>
+std::vector<std::size_t> ShardedStateSetTable::denseBases() const {
+	std::vector<std::size_t> bases(kShardCount + 1, 0);
+	for (std::size_t i = 0; i < kShardCount; i++)
+		bases[i + 1] = bases[i] + m_shards[i]->table.size();
+	return bases;
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/// <summary>
+/// dynamic bitset over nfa state ids, used as the key of a dfa state during subset construction
+/// </summary>
+class StateSet
+{
+protected:
+	std::vector<std::uint64_t> m_words;
+
+public:
+	StateSet() = default;
+	explicit StateSet(std::size_t stateCount) : m_words((stateCount + 63) / 64, 0) {}
+
+	void insert(std::size_t state) { m_words[state >> 6] |= std::uint64_t(1) << (state & 63); }
+	bool contains(std::size_t state) const { return (m_words[state >> 6] >> (state & 63)) & 1; }
+	void clear();
+	bool empty() const;
+	void unite(const StateSet& other);
+	bool intersects(const StateSet& other) const;
+
+	std::size_t wordCount() const { return m_words.size(); }
+	const std::uint64_t* words() const { return m_words.data(); }
+	std::uint64_t* words() { return m_words.data(); }
+
+	/// <summary>
+	/// calls f(state) for every state in the set, in increasing order
+	/// </summary>
+	template <typename F>
+	void forEach(F&& f) const {
+		for (std::size_t i = 0; i < m_words.size(); i++)
+			for (std::uint64_t word = m_words[i]; word != 0; word &= word - 1)
+				f(i * 64 + countTrailingZeros(word));
+	}
+
+	static std::size_t countTrailingZeros(std::uint64_t word);
+};
+
+/// <summary>
+/// hash-consing table of state sets: every distinct set is stored once in a flat word array and gets a dense id,
+/// so looking a set up costs one hash over its words and one comparison
+/// </summary>
+class StateSetTable
+{
+protected:
+	std::size_t m_wordsPerSet;
+	std::vector<std::uint64_t> m_words; // set i occupies [i * m_wordsPerSet, (i + 1) * m_wordsPerSet)
+	std::vector<std::uint64_t> m_hashes; // cached hash of every set
+	std::vector<std::uint32_t> m_buckets; // open addressing index, stores id + 1 (0 means empty)
+
+	static std::uint64_t hashWords(const std::uint64_t* words, std::size_t count);
+	void grow();
+
+public:
+	static constexpr std::uint32_t kNotFound = UINT32_MAX;
+
+	explicit StateSetTable(std::size_t stateCount);
+
+	std::pair<std::uint32_t, bool> intern(const StateSet& set);
+	std::uint32_t find(const StateSet& set) const;
+	void load(std::uint32_t id, StateSet& out) const;
+
+	std::size_t size() const { return m_hashes.size(); }
+	std::size_t wordsPerSet() const { return m_wordsPerSet; }
+	static std::uint64_t hash(const StateSet& set) { return hashWords(set.words(), set.wordCount()); }
+};
+
+/// <summary>
+/// StateSetTable split into shards with a lock each, so several threads can intern sets at the same time; a set
+/// goes to the shard picked by the top bits of its hash and its key is (id inside the shard) * kShardCount + shard
+/// </summary>
+class ShardedStateSetTable
+{
+protected:
+	struct Shard {
+		std::mutex mutex;
+		StateSetTable table;
+		explicit Shard(std::size_t stateCount) : table(stateCount) {}
+	};
+	std::vector<std::unique_ptr<Shard>> m_shards;
+
+public:
+	static constexpr std::size_t kShardBits = 6;
+	static constexpr std::size_t kShardCount = std::size_t(1) << kShardBits;
+
+	explicit ShardedStateSetTable(std::size_t stateCount);
+
+	std::pair<std::uint64_t, bool> intern(const StateSet& set);
+	std::vector<std::size_t> denseBases() const;
+
+	static std::size_t shardOf(std::uint64_t key) { return static_cast<std::size_t>(key & (kShardCount - 1)); }
+	static std::size_t idOf(std::uint64_t key) { return static_cast<std::size_t>(key >> kShardBits); }
+};
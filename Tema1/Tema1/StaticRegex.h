@@ -0,0 +1,413 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/// <summary>
+/// compile time counterpart of Automaton::buildDFA for expressions written in the source code. The expression goes
+/// through the same steps as at runtime (polish form, position automaton, subset construction, minimization), but
+/// inside constexpr functions, and the dfa ends up as a constant table: nothing is built or allocated at startup and
+/// the matching loop can be inlined by the compiler. The std::vectors used while building only live during constant
+/// evaluation
+/// </summary>
+namespace StaticRegexDetail {
+	/// <summary>
+	/// a string literal usable as a template argument
+	/// </summary>
+	template <std::size_t N>
+	struct Pattern
+	{
+		char text[N]{};
+
+		constexpr Pattern(const char (&literal)[N]) {
+			for (std::size_t i = 0; i < N; i++)
+				text[i] = literal[i];
+		}
+
+		constexpr std::string_view view() const { return std::string_view(text, N - 1); }
+	};
+
+	constexpr int priority(char c) {
+		if (c == '*' || c == '+' || c == '?')
+			return 3;
+		else if (c == '.')
+			return 2;
+		else if (c == '|')
+			return 1;
+		else
+			return -1;
+	}
+
+	constexpr bool isOperand(char c) {
+		return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+	}
+
+	using ByteSet = std::array<bool, 256>;
+
+	/// <summary>
+	/// same as CharClass::operandEnd
+	/// </summary>
+	constexpr std::size_t operandEnd(std::string_view expression, std::size_t position) {
+		if (expression[position] != '[')
+			return position + 1;
+		std::size_t i = position + 1;
+		if (i < expression.size() && expression[i] == '^')
+			i++;
+		if (i < expression.size() && expression[i] == ']')
+			i++;
+		const std::size_t close = expression.find(']', i);
+		return close == std::string_view::npos ? expression.size() : close + 1;
+	}
+
+	/// <summary>
+	/// same as CharClass::parse, with the class kept as one flag per byte
+	/// </summary>
+	constexpr bool parseOperand(std::string_view expression, std::size_t position, std::size_t end, ByteSet& bytes) {
+		bytes = {};
+		if (expression[position] != '[') {
+			bytes[static_cast<unsigned char>(expression[position])] = true;
+			return true;
+		}
+		if (end - position < 3 || expression[end - 1] != ']')
+			return false;
+		std::size_t i = position + 1;
+		const bool negated = expression[i] == '^';
+		if (negated)
+			i++;
+		const std::size_t close = end - 1;
+		if (i >= close)
+			return false;
+		while (i < close) {
+			const unsigned char first = static_cast<unsigned char>(expression[i]);
+			unsigned char last = first;
+			if (i + 2 < close && expression[i + 1] == '-') {
+				last = static_cast<unsigned char>(expression[i + 2]);
+				if (last < first)
+					return false;
+				i += 2;
+			}
+			for (unsigned int byte = first; byte <= last; byte++)
+				bytes[byte] = true;
+			i++;
+		}
+		if (negated)
+			for (bool& in : bytes)
+				in = !in;
+		return true;
+	}
+
+	/// <summary>
+	/// same as infixToPostfix; returns false for a ) without its (, where the runtime version is undefined
+	/// </summary>
+	constexpr bool toPostfix(std::string_view expression, std::vector<char>& result) {
+		std::vector<char> stack;
+		for (std::size_t i = 0; i < expression.size(); i++) {
+			const char c = expression[i];
+			if (isOperand(c))
+				result.push_back(c);
+			else if (c == '[') {
+				const std::size_t end = operandEnd(expression, i);
+				for (; i < end; i++)
+					result.push_back(expression[i]);
+				i--;
+			}
+			else if (c == '(')
+				stack.push_back('(');
+			else if (c == ')') {
+				while (!stack.empty() && stack.back() != '(') {
+					result.push_back(stack.back());
+					stack.pop_back();
+				}
+				if (stack.empty())
+					return false;
+				stack.pop_back();
+			}
+			else {
+				while (!stack.empty() && priority(c) <= priority(stack.back())) {
+					result.push_back(stack.back());
+					stack.pop_back();
+				}
+				stack.push_back(c);
+			}
+		}
+		while (!stack.empty()) {
+			result.push_back(stack.back());
+			stack.pop_back();
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// the minimized dfa while it is being built: state 0 is the dead state and column 0 is every byte outside the
+	/// alphabet, like in CompiledDFA; the other columns are the ranges of bytes no class of the expression tells apart
+	/// </summary>
+	struct Builder
+	{
+		bool valid = false;
+		std::vector<unsigned char> symbols; // first byte of every column after 0
+		std::array<std::uint8_t, 256> classOf{}; // byte -> column
+		std::vector<std::uint32_t> transitions; // stateCount rows of symbols.size() + 1 columns
+		std::vector<bool> accepting;
+		std::uint32_t initialState = 0;
+
+		constexpr std::size_t classCount() const { return symbols.size() + 1; }
+		constexpr std::size_t stateCount() const { return accepting.size(); }
+	};
+
+	struct Node
+	{
+		bool nullable = false;
+		std::vector<std::uint32_t> first;
+		std::vector<std::uint32_t> last;
+	};
+
+	constexpr void append(std::vector<std::uint32_t>& to, const std::vector<std::uint32_t>& from) {
+		for (const std::uint32_t position : from)
+			to.push_back(position);
+	}
+
+	/// <summary>
+	/// determinizes the position automaton of the polish form, like PositionAutomaton::fromPostfix followed by
+	/// CompiledDFA::fromNFA. Sets of positions are sorted lists, found again by a linear search, which is enough for
+	/// the expressions written in code
+	/// </summary>
+	constexpr void determinize(const std::vector<char>& postfix, Builder& dfa) {
+		const std::string_view polishForm(postfix.data(), postfix.size());
+		std::vector<ByteSet> bytesOf(1); // bytes of every position, position 0 is the initial state
+		std::vector<std::vector<std::uint32_t>> follow(1);
+		std::vector<Node> stack;
+		for (std::size_t i = 0; i < polishForm.size(); i++) {
+			const char symbol = polishForm[i];
+			const std::size_t operands = symbol == '.' || symbol == '|' ? 2 : symbol == '*' || symbol == '+' || symbol == '?' ? 1 : 0;
+			if (stack.size() < operands)
+				return;
+			if (operands == 0) {
+				const std::uint32_t position = static_cast<std::uint32_t>(bytesOf.size());
+				const std::size_t end = operandEnd(polishForm, i);
+				bytesOf.emplace_back();
+				if (!parseOperand(polishForm, i, end, bytesOf.back()))
+					return;
+				i = end - 1;
+				follow.emplace_back();
+				stack.push_back({ false, { position }, { position } });
+				continue;
+			}
+			if (operands == 1) {
+				Node& a = stack.back();
+				if (symbol != '?')
+					for (const std::uint32_t position : a.last)
+						append(follow[position], a.first);
+				if (symbol != '+')
+					a.nullable = true;
+				continue;
+			}
+			Node b = stack.back();
+			stack.pop_back();
+			Node& a = stack.back();
+			if (symbol == '|') {
+				a.nullable = a.nullable || b.nullable;
+				append(a.first, b.first);
+				append(a.last, b.last);
+				continue;
+			}
+			for (const std::uint32_t position : a.last)
+				append(follow[position], b.first);
+			if (a.nullable)
+				append(a.first, b.first);
+			if (b.nullable)
+				append(b.last, a.last);
+			a.last = b.last;
+			a.nullable = a.nullable && b.nullable;
+		}
+		if (stack.empty())
+			return;
+		follow[0] = stack.back().first;
+		std::vector<bool> final(bytesOf.size(), false);
+		for (const std::uint32_t position : stack.back().last)
+			final[position] = true;
+		final[0] = stack.back().nullable;
+
+		for (std::size_t byte = 0; byte < 256; byte++) { // a new column starts where some class starts or ends
+			bool covered = false, split = byte == 0 || dfa.classOf[byte - 1] == 0;
+			for (std::size_t position = 1; position < bytesOf.size(); position++) {
+				covered = covered || bytesOf[position][byte];
+				split = split || (byte > 0 && bytesOf[position][byte] != bytesOf[position][byte - 1]);
+			}
+			if (!covered)
+				continue;
+			if (split) {
+				if (dfa.symbols.size() == 255)
+					return;
+				dfa.symbols.push_back(static_cast<unsigned char>(byte));
+			}
+			dfa.classOf[byte] = static_cast<std::uint8_t>(dfa.symbols.size());
+		}
+		dfa.valid = true;
+		const std::size_t classCount = dfa.classCount();
+
+		std::vector<std::vector<std::uint32_t>> sets{ {}, { 0 } }; // the dead state and the initial state
+		dfa.initialState = 1;
+		for (std::size_t state = 0; state < sets.size(); state++) {
+			bool accepting = false;
+			for (const std::uint32_t position : sets[state])
+				accepting = accepting || final[position];
+			dfa.accepting.push_back(accepting);
+			dfa.transitions.push_back(0);
+			for (std::size_t column = 1; column < classCount; column++) {
+				std::vector<std::uint32_t> reached;
+				for (const std::uint32_t position : sets[state])
+					for (const std::uint32_t target : follow[position])
+						if (bytesOf[target][dfa.symbols[column - 1]])
+							reached.push_back(target);
+				std::sort(reached.begin(), reached.end());
+				reached.erase(std::unique(reached.begin(), reached.end()), reached.end());
+				std::size_t found = 0;
+				while (found < sets.size() && sets[found] != reached)
+					found++;
+				if (found == sets.size())
+					sets.push_back(reached);
+				dfa.transitions.push_back(static_cast<std::uint32_t>(found));
+			}
+		}
+	}
+
+	/// <summary>
+	/// moore's partition refinement; the block of the dead state stays 0, the other blocks are numbered in the order
+	/// their first state appears
+	/// </summary>
+	constexpr void minimize(Builder& dfa) {
+		const std::size_t n = dfa.stateCount();
+		const std::size_t classCount = dfa.classCount();
+		std::vector<std::uint32_t> block(n);
+		for (std::size_t state = 0; state < n; state++)
+			block[state] = dfa.accepting[state] != dfa.accepting[0] ? 1 : 0;
+		std::size_t blockCount = 0;
+		while (true) {
+			std::vector<std::uint32_t> representative; // first state of every new block
+			std::vector<std::uint32_t> newBlock(n);
+			for (std::size_t state = 0; state < n; state++) {
+				std::size_t found = 0;
+				for (; found < representative.size(); found++) {
+					const std::size_t other = representative[found];
+					bool same = block[other] == block[state];
+					for (std::size_t column = 0; same && column < classCount; column++)
+						same = block[dfa.transitions[other * classCount + column]] == block[dfa.transitions[state * classCount + column]];
+					if (same)
+						break;
+				}
+				if (found == representative.size())
+					representative.push_back(static_cast<std::uint32_t>(state));
+				newBlock[state] = static_cast<std::uint32_t>(found);
+			}
+			block = newBlock;
+			if (representative.size() == blockCount)
+				break;
+			blockCount = representative.size();
+		}
+
+		std::vector<std::uint32_t> transitions(blockCount * classCount);
+		std::vector<bool> accepting(blockCount);
+		for (std::size_t state = 0; state < n; state++) {
+			accepting[block[state]] = dfa.accepting[state];
+			for (std::size_t column = 0; column < classCount; column++)
+				transitions[block[state] * classCount + column] = block[dfa.transitions[state * classCount + column]];
+		}
+		dfa.transitions = transitions;
+		dfa.accepting = accepting;
+		dfa.initialState = block[dfa.initialState];
+	}
+
+	constexpr Builder build(std::string_view expression) {
+		Builder dfa;
+		std::vector<char> postfix;
+		if (!toPostfix(expression, postfix))
+			return dfa;
+		determinize(postfix, dfa);
+		if (dfa.valid)
+			minimize(dfa);
+		return dfa;
+	}
+
+	/// <summary>
+	/// the part of the built dfa that decides the size of the table
+	/// </summary>
+	struct Shape
+	{
+		bool valid;
+		std::size_t stateCount;
+		std::size_t classCount;
+	};
+
+	constexpr Shape shape(std::string_view expression) {
+		const Builder dfa = build(expression);
+		return { dfa.valid, dfa.valid ? dfa.stateCount() : 1, dfa.valid ? dfa.classCount() : 1 };
+	}
+
+	/// <summary>
+	/// smallest unsigned type that can number the states, so that small dfas take a few cache lines
+	/// </summary>
+	template <std::size_t StateCount>
+	using StateType = std::conditional_t<StateCount <= 256, std::uint8_t, std::conditional_t<StateCount <= 65536, std::uint16_t, std::uint32_t>>;
+
+	template <std::size_t StateCount, std::size_t ClassCount>
+	struct Table
+	{
+		using State = StateType<StateCount>;
+
+		std::array<std::uint8_t, 256> classOf{};
+		std::array<std::array<State, ClassCount>, StateCount> next{};
+		std::array<bool, StateCount> accepting{};
+		State initialState = 0;
+	};
+
+	template <std::size_t StateCount, std::size_t ClassCount>
+	constexpr Table<StateCount, ClassCount> table(std::string_view expression) {
+		using State = StateType<StateCount>;
+		const Builder dfa = build(expression);
+		Table<StateCount, ClassCount> result;
+		if (!dfa.valid)
+			return result;
+		result.classOf = dfa.classOf;
+		for (std::size_t state = 0; state < StateCount; state++) {
+			result.accepting[state] = dfa.accepting[state];
+			for (std::size_t column = 0; column < ClassCount; column++)
+				result.next[state][column] = static_cast<State>(dfa.transitions[state * ClassCount + column]);
+		}
+		result.initialState = static_cast<State>(dfa.initialState);
+		return result;
+	}
+}
+
+/// <summary>
+/// the minimized dfa of an expression known at compile time, e.g. StaticRegex<"a.(b|c)*">::matches(word). It
+/// accepts the same words as Automaton::buildDFA(expression); an expression buildDFA reports as invalid does not
+/// compile
+/// </summary>
+template <StaticRegexDetail::Pattern Expression>
+class StaticRegex
+{
+	static constexpr StaticRegexDetail::Shape kShape = StaticRegexDetail::shape(Expression.view());
+	static_assert(kShape.valid, "StaticRegex: invalid regular expression");
+	static constexpr auto kTable = StaticRegexDetail::table<kShape.stateCount, kShape.classCount>(Expression.view());
+
+public:
+	using State = typename decltype(kTable)::State;
+
+	static constexpr bool matches(std::string_view word) {
+		State state = kTable.initialState;
+		for (const char symbol : word)
+			state = kTable.next[state][kTable.classOf[static_cast<unsigned char>(symbol)]]; // the dead state loops on itself
+		return kTable.accepting[state];
+	}
+
+	/// <summary>
+	/// number of states, the dead state included
+	/// </summary>
+	/// <returns></returns>
+	static constexpr std::size_t stateCount() { return kShape.stateCount; }
+	static constexpr std::size_t classCount() { return kShape.classCount; }
+};
@@ -0,0 +1,90 @@
+#include "StreamMatcher.h"
+#include "PerformanceStats.h"
+#include "PositionAutomaton.h"
+
+StreamPattern::StreamPattern(CompiledDFA anchored, CompiledDFA unanchored)
+	: m_anchored(std::move(anchored)), m_unanchored(std::move(unanchored)) {
+}
+
+/// <summary>
+/// builds the dfas from the position automaton of the expression: its initial state has no incoming edges, so
+/// making it non final leaves every word except the empty one, and empty matches are not reported (like Searcher)
+/// </summary>
+/// <param name="polishForm"></param>
+/// <returns></returns>
+StreamPattern StreamPattern::fromPostfix(const std::string& polishForm) {
+	const IndexedNFA nfa = PositionAutomaton::fromPostfix(polishForm);
+	IndexedNFA nonEmpty(nfa.alphabet(), nfa.stateCount(), nfa.initialState());
+	for (const char symbol : nfa.alphabet())
+		nonEmpty.setRangeEnd(symbol, static_cast<char>(nfa.rangeEnd(symbol)));
+	for (IndexedNFA::StateId state = 0; state < nfa.stateCount(); state++)
+		for (const IndexedNFA::Edge& edge : nfa.edges(state))
+			nonEmpty.addEdge(state, edge.symbol, edge.target);
+	nfa.finalStates().forEach([&](std::size_t state) {
+		if (state != nfa.initialState())
+			nonEmpty.setFinal(static_cast<IndexedNFA::StateId>(state));
+	});
+	return StreamPattern(CompiledDFA::fromNFA(nfa).minimize(), CompiledDFA::fromNFA(nonEmpty, true).minimize());
+}
+
+StreamMatcher::StreamMatcher(const StreamPattern& pattern)
+	: m_pattern(&pattern), m_anchoredState(pattern.anchored().initialState()), m_unanchoredState(pattern.unanchored().initialState()) {
+}
+
+/// <summary>
+/// continues the stream with the next buffer and calls onMatch with the end offset (counted from the start of the
+/// stream) of every match ending inside it. Returns the number of those matches; nothing is done after finish
+/// </summary>
+/// <param name="data"></param>
+/// <param name="size"></param>
+/// <param name="onMatch"></param>
+/// <returns></returns>
+std::size_t StreamMatcher::feed(const char* data, std::size_t size, const std::function<void(std::uint64_t)>& onMatch) {
+	if (m_finished)
+		return 0;
+	STATS_ADD(bytesScanned, size);
+	const CompiledDFA& anchored = m_pattern->anchored();
+	const CompiledDFA& unanchored = m_pattern->unanchored();
+	if (m_anchoredState != CompiledDFA::kDeadState) // usually dies after a few bytes
+		m_anchoredState = anchored.walk(m_anchoredState, std::string_view(data, size));
+
+	std::size_t count = 0;
+	CompiledDFA::State state = m_unanchoredState;
+	for (std::size_t i = 0; i < size;) {
+		const CompiledDFA::State previous = state;
+		state = unanchored.next(state, static_cast<unsigned char>(data[i++]));
+		if (!unanchored.isAccepting(state)) {
+			if (state == previous && unanchored.isAccelerable(state)) // no match ends before its next exit byte
+				i = unanchored.findExit(state, data, i, size);
+			continue;
+		}
+		count++;
+		if (onMatch)
+			onMatch(m_offset + i);
+	}
+	m_unanchoredState = state;
+	m_offset += size;
+	m_matchCount += count;
+	STATS_ADD(matchesFound, count);
+	return count;
+}
+
+/// <summary>
+/// ends the stream and returns whether all of it is a word of the expression
+/// </summary>
+/// <returns></returns>
+bool StreamMatcher::finish() {
+	m_finished = true;
+	return accepted();
+}
+
+/// <summary>
+/// starts a new stream with the same pattern
+/// </summary>
+void StreamMatcher::reset() {
+	m_anchoredState = m_pattern->anchored().initialState();
+	m_unanchoredState = m_pattern->unanchored().initialState();
+	m_offset = 0;
+	m_matchCount = 0;
+	m_finished = false;
+}
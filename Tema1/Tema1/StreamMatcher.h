@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include "CompiledDFA.h"
+
+/// <summary>
+/// the two dfas an expression is matched with over a stream, built once and shared by all of its StreamMatchers
+/// </summary>
+class StreamPattern
+{
+protected:
+	CompiledDFA m_anchored; // decides if the whole stream is a word of the expression
+	CompiledDFA m_unanchored; // accepting exactly after the bytes where a non empty match ends
+
+	StreamPattern(CompiledDFA anchored, CompiledDFA unanchored);
+
+public:
+	static StreamPattern fromPostfix(const std::string& polishForm);
+
+	const CompiledDFA& anchored() const { return m_anchored; }
+	const CompiledDFA& unanchored() const { return m_unanchored; }
+};
+
+/// <summary>
+/// matches one stream that arrives in buffers: feed walks each buffer once and keeps only the dfa states and the
+/// number of bytes seen, so a match spanning two buffers is found without copying them. Matches are reported by
+/// their end offset in the stream; their start would need the bytes before the end, which are not kept
+/// </summary>
+class StreamMatcher
+{
+protected:
+	const StreamPattern* m_pattern;
+	CompiledDFA::State m_anchoredState;
+	CompiledDFA::State m_unanchoredState;
+	std::uint64_t m_offset = 0; // bytes fed since the start of the stream
+	std::uint64_t m_matchCount = 0;
+	bool m_finished = false;
+
+public:
+	explicit StreamMatcher(const StreamPattern& pattern);
+
+	std::size_t feed(const char* data, std::size_t size, const std::function<void(std::uint64_t)>& onMatch = {});
+	bool finish();
+	void reset();
+
+	bool accepted() const { return m_pattern->anchored().isAccepting(m_anchoredState); }
+	bool finished() const { return m_finished; }
+	std::uint64_t offset() const { return m_offset; }
+	std::uint64_t matchCount() const { return m_matchCount; }
+};
@@ -0,0 +1,74 @@
+#include "ThreadPool.h"
+
+/// <summary>
+/// starts threadCount - 1 workers, the thread calling run() being the last one
+/// </summary>
+/// <param name="threadCount"></param>
+ThreadPool::ThreadPool(std::size_t threadCount) {
+	for (std::size_t i = 1; i < threadCount; i++)
+		m_workers.emplace_back(&ThreadPool::work, this);
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_wake.notify_all();
+	for (auto& worker : m_workers)
+		worker.join();
+}
+
+/// <summary>
+/// takes tasks of the current job until there are none left
+/// </summary>
+void ThreadPool::runTasks() {
+	for (std::size_t task = m_nextTask++; task < m_taskCount; task = m_nextTask++)
+		(*m_task)(task);
+}
+
+void ThreadPool::work() {
+	std::size_t seenGeneration = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [&] { return m_stopping || m_generation != seenGeneration; });
+			if (m_stopping)
+				return;
+			seenGeneration = m_generation;
+		}
+		runTasks();
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_busyWorkers--;
+		}
+		m_done.notify_one();
+	}
+}
+
+/// <summary>
+/// runs task(0) .. task(taskCount - 1) spread over the pool and waits for all of them
+/// </summary>
+/// <param name="taskCount"></param>
+/// <param name="task"></param>
+void ThreadPool::run(std::size_t taskCount, const std::function<void(std::size_t)>& task) {
+	if (m_workers.empty() || taskCount <= 1) {
+		for (std::size_t i = 0; i < taskCount; i++)
+			task(i);
+		return;
+	}
+	std::lock_guard<std::mutex> runLock(m_runMutex);
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_task = &task;
+		m_taskCount = taskCount;
+		m_nextTask = 0;
+		m_busyWorkers = m_workers.size();
+		m_generation++;
+	}
+	m_wake.notify_all();
+	runTasks();
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_done.wait(lock, [&] { return m_busyWorkers == 0; });
+	m_task = nullptr;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// fixed set of worker threads that run the tasks 0..taskCount-1 of one job at a time; the calling thread helps
+/// with the job and run() returns once every task is done
+/// </summary>
+class ThreadPool
+{
+protected:
+	std::vector<std::thread> m_workers;
+	std::mutex m_runMutex; // serializes jobs posted from different threads
+	std::mutex m_mutex;
+	std::condition_variable m_wake; // a new job was posted or the pool is stopping
+	std::condition_variable m_done; // a worker finished its part of the job
+	const std::function<void(std::size_t)>* m_task = nullptr;
+	std::size_t m_taskCount = 0;
+	std::atomic<std::size_t> m_nextTask{ 0 };
+	std::size_t m_busyWorkers = 0;
+	std::size_t m_generation = 0; // incremented for every job, so workers can tell a new job from a spurious wakeup
+	bool m_stopping = false;
+
+	void work();
+	void runTasks();
+
+public:
+	explicit ThreadPool(std::size_t threadCount = std::thread::hardware_concurrency());
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+	~ThreadPool();
+
+	void run(std::size_t taskCount, const std::function<void(std::size_t)>& task);
+	std::size_t threadCount() const { return m_workers.size() + 1; }
+};
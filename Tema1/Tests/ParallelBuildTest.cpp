@@ -0,0 +1,78 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Automaton.h"
+#include "ThreadPool.h"
+
+/// <summary>
+/// (a|b)*.a.(a|b)^n, whose dfa has 2^(n+1) states: wide enough levels to be split over several tasks
+/// </summary>
+/// <param name="n"></param>
+/// <returns></returns>
+std::string nthFromEnd(std::size_t n)
+{
+	std::string expression = "(a|b)*.a";
+	for (std::size_t i = 0; i < n; i++)
+		expression += ".(a|b)";
+	return expression;
+}
+
+/// <summary>
+/// checks that two dfas have the same states, the same transition on every byte and the same final states
+/// </summary>
+/// <param name="expected"></param>
+/// <param name="actual"></param>
+/// <returns>a description of the first difference, empty if there is none</returns>
+std::string compare(const CompiledDFA& expected, const CompiledDFA& actual)
+{
+	if (actual.stateCount() != expected.stateCount())
+		return "state count " + std::to_string(actual.stateCount()) + " instead of " + std::to_string(expected.stateCount());
+	if (actual.initialState() != expected.initialState())
+		return "initial state " + std::to_string(actual.initialState()) + " instead of " + std::to_string(expected.initialState());
+	for (CompiledDFA::State state = 0; state < expected.stateCount(); state++) {
+		if (actual.isAccepting(state) != expected.isAccepting(state))
+			return "final flag of state " + std::to_string(state);
+		for (unsigned byte = 0; byte < 256; byte++)
+			if (actual.next(state, static_cast<unsigned char>(byte)) != expected.next(state, static_cast<unsigned char>(byte)))
+				return "transition of state " + std::to_string(state) + " on byte " + std::to_string(byte);
+	}
+	return "";
+}
+
+/// <summary>
+/// builds the dfa of every expression with fromNFAParallel and fromNFA, anchored and unanchored, from the Thompson
+/// and the position automaton, and checks that both give the same dfa; the exit code is 1 if any of them differ
+/// </summary>
+/// <returns></returns>
+int main()
+{
+	std::vector<std::string> expressions = {
+		"a",
+		"a.(b|c)*",
+		"(a|b)*.a.b.b",
+		"((((a|b)*)*)*)*.c",
+		"[a-z_].[a-z0-9_]*",
+		"[^0-9]+.[0-9].[0-9]?",
+		"(a.b?|[]^-]+).c?.(x|y)+",
+		"(a|b|c|d|e|f|g|h).(a|b|c|d|e|f|g|h)*.(x.y|y.x)+",
+	};
+	for (std::size_t n = 4; n <= 10; n += 3)
+		expressions.push_back(nthFromEnd(n));
+
+	ThreadPool pool(4); // fromNFAParallel falls back to fromNFA on a single thread
+	std::size_t failures = 0;
+	for (const std::string& expression : expressions)
+		for (Construction construction : { Construction::Thompson, Construction::Glushkov }) {
+			const IndexedNFA nfa = Automaton::buildIndexedNFA(expression, construction);
+			for (bool unanchored : { false, true }) {
+				const std::string difference = compare(CompiledDFA::fromNFA(nfa, unanchored), CompiledDFA::fromNFAParallel(nfa, pool, unanchored));
+				if (difference.empty())
+					continue;
+				std::cout << expression << (construction == Construction::Glushkov ? " (glushkov" : " (thompson")
+					<< (unanchored ? ", unanchored): " : ", anchored): ") << difference << "\n";
+				failures++;
+			}
+		}
+	std::cout << expressions.size() * 4 - failures << " of " << expressions.size() * 4 << " builds match\n";
+	return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,90 @@
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+#include "Automaton.h"
+#include "StaticRegex.h"
+
+/// <summary>
+/// bytes the words are made of: the first byte of every symbol range of a dfa and the bytes next to it, so
+/// the ends of every range are tried, and two bytes no expression below uses. The byte 0 is left out, since Automaton
+/// uses it for lambda and buildDFA never matches it
+/// </summary>
+/// <param name="ranges">a dfa built from the symbol ranges, unlike Automaton which has one symbol per byte</param>
+/// <returns></returns>
+std::string testBytes(const CompiledDFA& ranges)
+{
+	std::set<unsigned char> bytes = { 0x01, 0xFF };
+	for (char symbol : ranges.alphabet()) {
+		const unsigned char byte = static_cast<unsigned char>(symbol);
+		if (byte != 0)
+			bytes.insert(byte);
+		if (byte > 1)
+			bytes.insert(byte - 1);
+		if (byte < 0xFF)
+			bytes.insert(byte + 1);
+	}
+	return std::string(bytes.begin(), bytes.end());
+}
+
+/// <summary>
+/// matches every word of the test bytes up to the longest length that keeps them under about a million with
+/// StaticRegex and with the dfa Automaton::buildDFA builds at runtime; returns the number of words they disagree on
+/// </summary>
+/// <returns></returns>
+template <StaticRegexDetail::Pattern Expression>
+std::size_t checkExpression()
+{
+	const std::string expression(Expression.view());
+	const CompiledDFA compiled = Automaton::buildDFA(expression).compile();
+	const std::string bytes = testBytes(Automaton::buildCompiledDFA(expression));
+	std::size_t maxLength = 0;
+	for (std::size_t words = bytes.size(); words <= 1000000; words *= bytes.size())
+		maxLength++;
+
+	std::size_t disagreements = 0, checked = 0;
+	std::string word;
+	std::vector<std::size_t> digits; // index in bytes of every byte of word
+	while (true) {
+		checked++;
+		if (compiled.matches(word) != StaticRegex<Expression>::matches(word) && disagreements++ < 5)
+			std::cout << expression << ": disagrees on a word of length " << word.size() << ", runtime dfa "
+				<< (compiled.matches(word) ? "accepts" : "rejects") << " it\n";
+		std::size_t position = 0; // next word in length then lexicographic order
+		while (position < digits.size() && digits[position] + 1 == bytes.size()) {
+			digits[position] = 0;
+			word[position++] = bytes[0];
+		}
+		if (position == digits.size()) {
+			if (digits.size() == maxLength)
+				break;
+			digits.push_back(0);
+			word.push_back(bytes[0]);
+		}
+		else
+			word[position] = bytes[++digits[position]];
+	}
+	std::cout << expression << ": " << checked << " words up to length " << maxLength << ", " << disagreements << " disagreements\n";
+	return disagreements;
+}
+
+/// <summary>
+/// compares StaticRegex with the runtime dfa on expressions with classes, complements, ?, +, nested stars and the
+/// literal ] and - of a class; the exit code is 1 if they disagree on any word
+/// </summary>
+/// <returns></returns>
+int main()
+{
+	std::size_t disagreements = 0;
+	disagreements += checkExpression<"a">();
+	disagreements += checkExpression<"a.(b|c)*">();
+	disagreements += checkExpression<"(a|b)*.a.(a|b).(a|b)">();
+	disagreements += checkExpression<"((a*.b)*|c+)*.d?">();
+	disagreements += checkExpression<"(((a|b)*)*.c)*">();
+	disagreements += checkExpression<"[a-z_].[a-z0-9_]*">();
+	disagreements += checkExpression<"[^0-9]+.[0-9].[0-9]?">();
+	disagreements += checkExpression<"(a.b?|[]^-]+).c?.(x|y)+">();
+	disagreements += checkExpression<"[]a]*.[^]-]+.[-x]?">();
+	disagreements += checkExpression<"(a?.b?)+.[b-d]?">();
+	return disagreements > 0 ? 1 : 0;
+}
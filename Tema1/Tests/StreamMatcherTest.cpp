@@ -0,0 +1,77 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "Automaton.h"
+#include "ThreadPool.h"
+
+/// <summary>
+/// one searched expression and the bytes its text is drawn from
+/// </summary>
+struct StreamCase
+{
+	std::string expression;
+	std::string textAlphabet;
+};
+
+/// <summary>
+/// feeds the text to a StreamMatcher in buffers of bufferSize bytes and returns the end offsets it reports
+/// </summary>
+/// <param name="pattern"></param>
+/// <param name="text"></param>
+/// <param name="bufferSize"></param>
+/// <returns></returns>
+std::vector<std::size_t> streamEnds(const StreamPattern& pattern, const std::string& text, std::size_t bufferSize)
+{
+	std::vector<std::size_t> ends;
+	StreamMatcher matcher(pattern);
+	for (std::size_t offset = 0; offset < text.size(); offset += bufferSize)
+		matcher.feed(text.data() + offset, std::min(bufferSize, text.size() - offset), [&](std::uint64_t end) { ends.push_back(end); });
+	if (matcher.matchCount() != ends.size())
+		ends.push_back(0); // a count that disagrees with the reported ends is a difference too
+	return ends;
+}
+
+/// <summary>
+/// checks that StreamMatcher reports the same match ends as the all-matches search, sequential and on a thread pool,
+/// whatever the size of the buffers the text arrives in; the exit code is 1 if any of them differ
+/// </summary>
+/// <returns></returns>
+int main()
+{
+	const std::vector<StreamCase> cases = {
+		{ "[a-z]+", "ab z0 " },
+		{ "a.b.c.d|c", "abcd" },
+		{ "(a|b)*.a.(a|b).(a|b)", "ab" },
+		{ "[0-9]+.[.].[0-9]+", "0123456789.x" },
+		{ "x.y*.z?", "xyzw" },
+		{ "[^ ]+.[@].[a-z]+", "ab@ .z" },
+	};
+	ThreadPool pool(4); // searchParallel cuts a text this long in several chunks
+	std::mt19937 random(11);
+	std::size_t failures = 0;
+	for (const StreamCase& test : cases) {
+		std::string text(1 << 20, ' ');
+		for (char& byte : text)
+			byte = test.textAlphabet[random() % test.textAlphabet.size()];
+		const Searcher searcher = Automaton::buildSearcher(test.expression);
+		std::vector<std::size_t> allEnds, parallelEnds;
+		searcher.search(text, SearchMode::AllMatches, [&](const Match& match) { allEnds.push_back(match.end); });
+		searcher.searchParallel(text, pool, [&](const Match& match) { parallelEnds.push_back(match.end); });
+		if (parallelEnds != allEnds) {
+			std::cout << test.expression << ": searchParallel finds " << parallelEnds.size() << " matches, search " << allEnds.size() << "\n";
+			failures++;
+		}
+		const StreamPattern pattern = Automaton::buildStreamPattern(test.expression);
+		for (std::size_t bufferSize : { std::size_t(1), std::size_t(7), std::size_t(1500), text.size() }) {
+			const std::vector<std::size_t> ends = streamEnds(pattern, text, bufferSize);
+			if (ends == allEnds)
+				continue;
+			std::cout << test.expression << ": StreamMatcher with " << bufferSize << " byte buffers finds " << ends.size()
+				<< " matches, search " << allEnds.size() << "\n";
+			failures++;
+		}
+		std::cout << test.expression << ": " << allEnds.size() << " matches\n";
+	}
+	return failures > 0 ? 1 : 0;
+}